@@ -0,0 +1,100 @@
+/* Sums numbers and string lengths of an array of records, once
+ * walking the tree with Jiter, dynamic_cast and virtual getters,
+ * once with Cursor */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "../jsoner.h"
+
+using namespace std;
+using namespace J;
+
+/* visits members of obj the way it was done with Jiter */
+void walk(Obj* obj, int64_t& sum){
+    for (Jiter it=obj->begin();it!=obj->end();++it){
+
+        if (Obj* x=it.getObj()){
+            walk(x, sum);
+            continue;
+        }
+
+        switch (it->Type()) {
+        case JType::Number:
+            sum+=it->getInt64();
+            break;
+        case JType::String:
+            sum+=it->getStr().size();
+            break;
+        case JType::Array:
+            if (auto a=dynamic_cast<Arr<int32_t>*>(it.operator->()))
+                for (auto v: a->value)
+                    sum+=v;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void walk(Cursor c, int64_t& sum){
+    for (Cursor x: c){
+        switch (x.type()) {
+        case JType::Object:
+        case JType::Array:
+            walk(x, sum);
+            break;
+        case JType::Number:
+            sum+=x.as<int64_t>();
+            break;
+        case JType::String:
+            sum+=x.as<string_view>().size();
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    size_t records=argc>1?strtoul(argv[1], nullptr, 10):100000;
+    int rounds=20;
+
+    string input="{\"items\": [";
+
+    for (size_t i=0;i<records;++i)
+        input+=string(i?", ":"")+"{\"id\": "+to_string(i)+", \"name\": \"record "+to_string(i)
+              +"\", \"flag\": true, \"pos\": {\"x\": "+to_string(i%100)+", \"y\": 7}, \"v\": [1, 2, 3]}";
+
+    input+="]}";
+
+    JSON doc;
+    doc.Parse(input);
+
+    Arr<Obj*>& items=dynamic_cast<Arr<Obj*>&>(doc["items"]);
+
+    auto run=[&](const char* name, auto f){
+        int64_t sum=0;
+        auto start=chrono::steady_clock::now();
+
+        for (int r=0;r<rounds;++r)
+            f(sum);
+
+        double sec=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+        cout << setw(8) << name << ": " << fixed << setprecision(2) << sec/rounds*1e3
+             << " ms per pass, " << setprecision(1) << records*rounds/sec/1e6
+             << " M records/s (sum " << sum/rounds << ")" << endl;
+    };
+
+    run("Jiter", [&](int64_t& sum){
+        for (auto x: items.value)
+            walk(x, sum);
+    });
+
+    run("Cursor", [&](int64_t& sum){
+        walk(Cursor(doc)["items"], sum);
+    });
+
+    return 0;
+}
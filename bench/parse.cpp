@@ -0,0 +1,72 @@
+/* Parses a stream of records sharing one schema: generic Parse
+ * into a new document, reset()+Parse, reset()+Parse(shape) and
+ * reset()+Parse(projection) of two members */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include "../jsoner.h"
+
+using namespace std;
+using namespace J;
+
+int main(int argc, char **argv){
+    size_t count=argc>1?strtoul(argv[1], nullptr, 10):100000;
+
+    vector<string> records;
+    size_t bytes=0;
+
+    for (size_t i=0;i<count;++i){
+        records.push_back("{\"id\": "+to_string(i)+", \"name\": \"user"+to_string(i)
+                          +"\", \"email\": \"user"+to_string(i)+"@example.com\", \"active\": "
+                          +(i%2?"true":"false")+", \"score\": "+to_string(i%1000)+".5, \"address\": "
+                          "{\"city\": \"Springfield\", \"zip\": \""+to_string(10000+i%90000)+"\"}, \"tags\": [\"a\", \"b\"]}");
+        bytes+=records.back().size();
+    }
+
+    auto run=[&](const char* name, auto f){
+        auto start=chrono::steady_clock::now();
+        size_t sum=0;
+
+        for (auto& x: records)
+            sum+=f(x);
+
+        double sec=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+        cout << setw(14) << name << ": " << fixed << setprecision(1) << count/sec/1e6
+             << " M records/s, " << bytes/sec/1e6 << " MB/s (" << sum << ")" << endl;
+    };
+
+    run("Parse", [](const string& x){
+        JSON doc;
+        doc.Parse(x);
+        return (size_t)doc["id"].getInt();
+    });
+
+    JSON doc;
+
+    run("reset+Parse", [&](const string& x){
+        doc.reset();
+        doc.Parse(x);
+        return (size_t)doc["id"].getInt();
+    });
+
+    Shape shape;
+
+    run("reset+Shape", [&](const string& x){
+        doc.reset();
+        doc.Parse(x, shape);
+        return (size_t)doc["id"].getInt();
+    });
+
+    Projection proj{"id", "address.zip"};
+
+    run("reset+Project", [&](const string& x){
+        doc.reset();
+        doc.Parse(x, proj);
+        return (size_t)doc["id"].getInt();
+    });
+
+    return 0;
+}
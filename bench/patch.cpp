@@ -0,0 +1,67 @@
+/* Single field edits of a 1 MB document: apply_patch and
+ * merge_patch on text against Parse, set() and toStr() */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "../jsoner.h"
+
+using namespace std;
+using namespace J;
+
+int main(int argc, char **argv){
+    size_t size=argc>1?strtoul(argv[1], nullptr, 10):1<<20;
+    int rounds=50;
+
+    string doc="{";
+
+    for (size_t i=0;doc.size()<size;++i)
+        doc+="\"k"+to_string(i)+"\": {\"id\": "+to_string(i)+", \"name\": \"record "+to_string(i)
+            +"\", \"tags\": [\"a\", \"b\"]}, ";
+
+    doc+="\"last\": {\"id\": 0, \"name\": \"end\", \"tags\": []}}";
+
+    auto run=[&](const char* name, auto f){
+        size_t out=0;
+        auto start=chrono::steady_clock::now();
+
+        for (int r=0;r<rounds;++r)
+            out+=f().size();
+
+        double sec=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+        cout << setw(16) << name << ": " << fixed << setprecision(3) << sec/rounds*1e3
+             << " ms per edit, " << setprecision(1) << doc.size()*rounds/sec/1e6
+             << " MB/s (" << out/rounds << " bytes)" << endl;
+    };
+
+    cout << doc.size() << " bytes" << endl;
+
+    run("replace", [&](){
+        return apply_patch(doc, "[{\"op\": \"replace\", \"path\": \"/last/id\", \"value\": 42}]");
+    });
+
+    run("add", [&](){
+        return apply_patch(doc, "[{\"op\": \"add\", \"path\": \"/last/tags/-\", \"value\": \"c\"}]");
+    });
+
+    run("remove", [&](){
+        return apply_patch(doc, "[{\"op\": \"remove\", \"path\": \"/last/name\"}]");
+    });
+
+    run("merge_patch", [&](){
+        return merge_patch(doc, "{\"last\": {\"id\": 42}}");
+    });
+
+    run("Parse+set+toStr", [&](){
+        JSON j;
+        j.Parse(doc);
+
+        Obj& last=dynamic_cast<Obj&>(j["last"]);
+        ((Num<int32_t>*)last.findProperty("id"))->set(42);
+
+        return j.toStr();
+    });
+
+    return 0;
+}
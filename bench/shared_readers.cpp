@@ -0,0 +1,77 @@
+/* Reads of one Shared document from 1..N threads while a writer
+ * publishes new versions. Reads per second should grow with the
+ * number of readers, as between versions they only load an atomic
+ * counter; they lock in Shared::get once per published version */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "../jsoner.h"
+
+using namespace std;
+using namespace J;
+
+int main(int argc, char **argv){
+    size_t max_threads=argc>1?strtoul(argv[1], nullptr, 10):max(4u, thread::hardware_concurrency());
+
+    string input="{\"version\": 0, \"items\": [";
+
+    for (int i=0;i<100;++i)
+        input+=string(i?", ":"")+"{\"id\": "+to_string(i)+", \"name\": \"item"+to_string(i)+"\"}";
+
+    input+="]}";
+
+    Shared doc(make_shared<const Frozen>(input));
+
+    for (size_t n=1;n<=max_threads;n*=2){
+
+        atomic<bool> stop{false};
+        atomic<uint64_t> reads{0}, checksum{0};
+
+        vector<thread> readers;
+
+        for (size_t i=0;i<n;++i){
+            readers.emplace_back([&](){
+                Reader r(doc);
+                uint64_t count=0, sum=0;
+
+                while (!stop.load(memory_order_relaxed)){
+                    const Frozen& f=r.get();
+
+                    sum+=f["items"][size_t(count%100)]["id"].as<int32_t>();
+                    ++count;
+                }
+
+                reads+=count;
+                checksum+=sum;
+            });
+        }
+
+        /* writer publishes a version every millisecond */
+        thread writer([&](){
+            for (int v=1;!stop.load();++v){
+                doc.update([v](Obj& o){
+                    ((Num<int32_t>*)o.findProperty("version"))->set(v);
+                });
+
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        });
+
+        this_thread::sleep_for(chrono::milliseconds(500));
+        stop=true;
+
+        for (auto& x: readers)
+            x.join();
+
+        writer.join();
+
+        cout << setw(3) << n << " readers: " << fixed << setprecision(1)
+             << reads/0.5/1e6 << " M reads/s" << endl;
+    }
+
+    return 0;
+}
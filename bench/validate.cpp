@@ -0,0 +1,60 @@
+/* Throughput of validate() on a large document, compared with
+ * std::count of one character over the same buffer as a bound
+ * of what a single pass over memory costs */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include "../jsoner.h"
+
+using namespace std;
+using namespace J;
+
+int main(int argc, char **argv){
+    size_t count=argc>1?strtoul(argv[1], nullptr, 10):500000;
+    int rounds=10;
+
+    string doc="[";
+
+    for (size_t i=0;i<count;++i){
+        if (i)
+            doc+=",\n";
+
+        doc+="{\"id\": "+to_string(i)+", \"name\": \"user"+to_string(i)
+             +"\", \"email\": \"user"+to_string(i)+"@example.com\", \"active\": "
+             +(i%2?"true":"false")+", \"score\": "+to_string(i%1000)+".5, \"address\": "
+             "{\"city\": \"Springfield\", \"zip\": \""+to_string(10000+i%90000)+"\"}, "
+             "\"tags\": [\"a\", \"b\"], \"pos\": [-"+to_string(i%180)+".25, 1.5e-3]}";
+    }
+
+    doc+="]";
+
+    auto run=[&](const char* name, auto f){
+        size_t sum=0;
+        auto start=chrono::steady_clock::now();
+
+        for (int i=0;i<rounds;++i)
+            sum+=f();
+
+        double sec=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+        cout << setw(10) << name << ": " << fixed << setprecision(1)
+             << doc.size()*rounds/sec/1e6 << " MB/s (" << sum << ")" << endl;
+    };
+
+    run("count", [&](){
+        return (size_t)std::count(doc.begin(), doc.end(), '\n');
+    });
+
+    run("validate", [&](){
+        Status st=validate(doc.data(), doc.size());
+
+        if (!st)
+            cerr << st.reason << " at " << st.offset << endl;
+
+        return (size_t)st.ok;
+    });
+
+    return 0;
+}
@@ -5,6 +5,30 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <thread>
+#include <condition_variable>
+#include <cstdio>
+
+#ifdef JSONER_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef JSONER_WITH_ZSTD
+#include <zstd.h>
+#endif
 
 #include <iostream>
 
@@ -33,6 +57,15 @@ size_t detect_closing_bracket(const string& str, size_t from, char l_bracket='{'
 
 //        cout << "open: " << open_brackets << endl;
 
+        /* brackets inside strings don't count */
+        if (str[i]=='"'){
+            for (++i;i<str.size()&&str[i]!='"';++i)
+                if (str[i]=='\\')
+                    ++i;
+
+            continue;
+        }
+
         if (str[i]==l_bracket)
             ++open_brackets;
 
@@ -46,6 +79,157 @@ size_t detect_closing_bracket(const string& str, size_t from, char l_bracket='{'
     return string::npos;
 }
 
+/* returns position of first non whitespace character at or after from */
+size_t skip_ws(const string& str, size_t from){
+    while (from<str.size()&&::isspace(str[from]))
+        ++from;
+
+    return from;
+}
+
+/* matches '"key"' followed by ':' at pos, on success moves pos
+ * to the first character of the value */
+bool match_key(const string& str, size_t& pos, const string& key){
+    size_t p=pos;
+
+    if (str[p]!='"')
+        return false;
+
+    ++p;
+
+    if (str.size()-p<key.size()+1||str.compare(p, key.size(), key)!=0)
+        return false;
+
+    p+=key.size();
+
+    if (str[p]!='"')
+        return false;
+
+    p=skip_ws(str, p+1);
+
+    if (str[p]!=':')
+        return false;
+
+    pos=skip_ws(str, p+1);
+
+    return true;
+}
+
+/* true if s[0..8) are all digits */
+bool is_8digits(const char* s){
+    uint64_t v;
+    memcpy(&v, s, 8);
+
+    return (((v&0xF0F0F0F0F0F0F0F0ULL)|(((v+0x0606060606060606ULL)&0xF0F0F0F0F0F0F0F0ULL)>>4))==0x3333333333333333ULL);
+}
+
+/* converts 8 digits at once */
+uint32_t parse_8digits(const char* s){
+    uint64_t v;
+    memcpy(&v, s, 8);
+
+    v-=0x3030303030303030ULL;
+    v=(v*10)+(v>>8);
+    v=(((v&0x000000FF000000FFULL)*(100+(1000000ULL<<32)))+(((v>>16)&0x000000FF000000FFULL)*(1+(10000ULL<<32))))>>32;
+
+    return (uint32_t)v;
+}
+
+/* converts integer [b, e) with optional '-', 8 digits a step.
+ * Throws std::out_of_range like stoll if it doesn't fit int64_t */
+int64_t parse_int(const char* b, const char* e){
+    const char* num=b;
+    bool neg=(*b=='-');
+
+    if (neg)
+        ++b;
+
+    /* 19 digits don't overflow uint64_t */
+    if (e-b>19)
+        throw std::out_of_range("integer out of range "+string(num, e));
+
+    uint64_t res=0;
+
+    while (e-b>=8&&is_8digits(b)){
+        res=res*100000000+parse_8digits(b);
+        b+=8;
+    }
+
+    for (;b<e;++b)
+        res=res*10+(*b-'0');
+
+    if (res>(uint64_t)std::numeric_limits<int64_t>::max()+neg)
+        throw std::out_of_range("integer out of range "+string(num, e));
+
+    return neg?(int64_t)(0-res):(int64_t)res;
+}
+
+/* checks that integer [b, e) with optional '-' fits int32_t
+ * without converting it, digits are compared as text */
+bool fits_int32(const char* b, const char* e){
+    bool neg=(*b=='-');
+
+    if (neg)
+        ++b;
+
+    if (e-b!=10)
+        return e-b<10;
+
+    return memcmp(b, neg?"2147483648":"2147483647", 10)<=0;
+}
+
+/* returns position after number starting at from,
+ * real is set if it has fraction or exponent */
+size_t number_end(const string& str, size_t from, bool& real){
+    const char* d=str.c_str();
+
+    for (;;++from){
+        char c=d[from];
+
+        if ((c>='0'&&c<='9')||c=='-')
+            continue;
+
+        if (c=='.'||c=='e'||c=='E'||c=='+')
+            real=true;
+        else return from;
+    }
+}
+
+/* returns position right after the value starting at from,
+ * objects and arrays are skipped by bracket matching */
+size_t skip_value(const string& str, size_t from){
+
+    size_t res;
+
+    switch (str[from]) {
+    case '"':
+        res=str.find('"', from+1);
+
+        /* skip escaped quotes */
+        for (size_t b;res!=string::npos;res=str.find('"', res+1)){
+            for (b=res;str[b-1]=='\\';--b);
+
+            if ((res-b)%2==0)
+                break;
+        }
+        break;
+    case '{':
+        res=detect_closing_bracket(str, from+1);
+        break;
+    case '[':
+        res=detect_closing_bracket(str, from+1, '[', ']');
+        break;
+    default:
+        res=str.find_first_of(",}] \t\r\n", from);
+        return res==string::npos?str.size():res;
+    }
+
+    if (res==string::npos)
+        throw std::logic_error(string("'")+str[from]+"' not closed "+std::to_string(from));
+
+    return res+1;
+}
+
 } //Hlp namespace
 
 enum class JType{
@@ -64,6 +248,29 @@ enum NType{
     ld
 };
 
+/* concrete type of a property, lets Cursor read values
+ * without virtual calls and dynamic_cast */
+enum class Kind: uint8_t{
+    Other,
+    I32,
+    I64,
+    D,
+    LD,
+    String,
+    Bool,
+    Null,
+    Object,
+    ArrI32,
+    ArrI64,
+    ArrD,
+    ArrLD,
+    ArrString,
+    ArrBool,
+    ArrNull,
+    ArrObject,
+    ArrAny
+};
+
 const char * ntype_tostr(NType t){
     switch (t) {
     case NType::i32:
@@ -111,13 +318,102 @@ NType detect_num_type(const string& str){
 
     } else {
 
-        if (str.size()>10){
+        if (!Hlp::fits_int32(str.data(), str.data()+str.size())){
             return NType::i64;
         }
         else return NType::i32;
     }
 }
 
+/* Shape remembers the layout of a parsed object: order of keys
+ * and types of their values. Records sharing one schema are parsed
+ * against it without looking for keys and detecting types again */
+struct Shape{
+
+    struct slot{
+        string key;
+        JType type;
+        NType ntype;
+
+        /* layout of nested object */
+        std::vector<Shape> sub;
+    };
+
+    bool empty() const {
+        return slots.empty();
+    }
+
+    void clear(){
+        slots.clear();
+    }
+
+    std::vector<slot> slots;
+};
+
+/* Projection is a set of key paths like "user.name", compiled
+ * into a trie. Parsing with projection creates only members on
+ * these paths, everything else is skipped */
+struct Projection{
+
+    struct node{
+        /* key and index of child node */
+        std::vector<std::pair<string, size_t>> children;
+
+        /* path ends here, value is taken whole */
+        bool leaf{false};
+    };
+
+    Projection():nodes(1){}
+
+    Projection(std::initializer_list<string> paths):nodes(1){
+        for (auto& x: paths)
+            add(x);
+    }
+
+    /* adds path with keys separated by '.' */
+    void add(const string& path){
+
+        size_t cur=0;
+
+        for (size_t l=0, r;l<=path.size();l=r+1){
+
+            r=path.find('.', l);
+
+            if (r==string::npos)
+                r=path.size();
+
+            cur=child(cur, path.substr(l, r-l));
+        }
+
+        nodes[cur].leaf=true;
+    }
+
+    /* returns child of node n with key key[0..len), 0 if none */
+    size_t find(size_t n, const char* key, size_t len) const {
+        for (auto& x: nodes[n].children)
+            if (x.first.size()==len&&x.first.compare(0, len, key, len)==0)
+                return x.second;
+
+        return 0;
+    }
+
+    std::vector<node> nodes;
+
+private:
+
+    size_t child(size_t n, const string& key){
+        size_t res=find(n, key.c_str(), key.size());
+
+        if (res)
+            return res;
+
+        nodes.push_back(node());
+        nodes[n].children.emplace_back(key, nodes.size()-1);
+
+        return nodes.size()-1;
+    }
+};
+
 using std::string;
 using std::stringstream;
 
@@ -128,6 +424,22 @@ std::string enclose(const std::string& str){
     return "\""+str+"\"";
 }
 
+/* "name": prefix of property, nothing for unnamed values
+ * such as array elements. Members with empty key get their
+ * prefix from the object, see Obj::write */
+std::string named(const std::string& name){
+    return name.empty()?string():enclose(name)+": ";
+}
+
+/* Kind of Num<T> and Arr<T> */
+template <typename T> struct kind_of{ static const Kind num=Kind::Other, arr=Kind::Other; };
+template <> struct kind_of<int32_t>{ static const Kind num=Kind::I32, arr=Kind::ArrI32; };
+template <> struct kind_of<int64_t>{ static const Kind num=Kind::I64, arr=Kind::ArrI64; };
+template <> struct kind_of<double>{ static const Kind num=Kind::D, arr=Kind::ArrD; };
+template <> struct kind_of<long double>{ static const Kind num=Kind::LD, arr=Kind::ArrLD; };
+template <> struct kind_of<string>{ static const Kind arr=Kind::ArrString; };
+template <> struct kind_of<bool>{ static const Kind arr=Kind::ArrBool; };
+
 /* Abstract property */
 
 struct prop{
@@ -136,52 +448,109 @@ struct prop{
 
     prop(const std::string& name):m_name(name){}
 
-    string Name(){ return m_name; }
+    prop(Kind kind):m_kind(kind){}
+
+    prop(const std::string& name, Kind kind):m_name(name),m_kind(kind){}
+
+    /* copies don't belong to container of op2 */
+    prop(const prop& op2):m_name(op2.m_name),m_kind(op2.m_kind){}
+
+    prop& operator=(const prop& op2){
+        m_name=op2.m_name;
+        return *this;
+    }
+
+    string Name() const { return m_name; }
 
     std::string m_name{""};
 
-    virtual int getInt(){}
-    virtual double getDouble(){}
-    virtual int64_t getInt64(){}
-    virtual long double getLDouble(){}
-    virtual std::string getStr(){}
-    virtual bool getBool(){}
-    virtual std::string toStr() const {}
-    virtual JType Type()=0;
+    const Kind m_kind{Kind::Other};
+
+    /* Container of this property, known once it was serialized
+     * with fragments kept, see Obj::keepFragments */
+    mutable const prop* m_parent{nullptr};
+
+    /* marks this property and containers above it as changed,
+     * has to be called after changing value or props directly */
+    void touch() const {
+        for (const prop* p=this;p;p=p->m_parent)
+            p->dirty();
+    }
+
+    /* appends toStr() to out */
+    virtual void write(std::string& out) const {
+        out+=toStr();
+    }
+
+    virtual int getInt() const { throw std::logic_error(m_name+" is not a number"); }
+    virtual double getDouble() const { throw std::logic_error(m_name+" is not a number"); }
+    virtual int64_t getInt64() const { throw std::logic_error(m_name+" is not a number"); }
+    virtual long double getLDouble() const { throw std::logic_error(m_name+" is not a number"); }
+    virtual std::string getStr() const { throw std::logic_error(m_name+" is not a string"); }
+    virtual bool getBool() const { throw std::logic_error(m_name+" is not a bool"); }
+    virtual std::string toStr() const { return string(); }
+    virtual JType Type() const =0;
+
+    /* deep copy */
+    virtual prop* clone() const =0;
 
     virtual ~prop(){}
+
+    /* drops cached fragment */
+    virtual void dirty() const {}
+
+    /* enables fragments for nested objects */
+    virtual void keep() const {}
+
+    /* clears m_parent and kept fragments here and in nested
+     * values, see Frozen */
+    virtual void detach() const {
+        m_parent=nullptr;
+    }
 };
 
 template <typename T>
 struct Num: prop{
 
     Num(const std::string& name,
-        const T& val):prop(name),value(val){}
+        const T& val):prop(name, kind_of<T>::num),value(val){}
+
+    Num():prop(kind_of<T>::num),value(){}
 
-    Num(T val):value(val){}
+    Num(T val):prop(kind_of<T>::num),value(val){}
 
-    int64_t getInt64(){
+    int64_t getInt64() const {
         return value;
     }
 
-    int32_t getInt(){
+    int32_t getInt() const {
         return value;
     }
 
-    double getDouble(){
+    double getDouble() const {
         return value;
     }
 
     std::string toStr() const {
         string res=std::to_string(value);
 
-        res.erase(res.find_last_not_of('0')+1, string::npos);
-        res.erase(res.find_last_not_of('.')+1, string::npos);
+        /* zeros of fraction only */
+        if (res.find('.')!=string::npos){
+            res.erase(res.find_last_not_of('0')+1, string::npos);
+            res.erase(res.find_last_not_of('.')+1, string::npos);
+        }
+
+        return named(m_name)+res;
+    }
 
-        return enclose(m_name)+": "+res;
+    void set(const T& val){
+        value=val;
+        touch();
     }
 
-    JType Type(){ return JType::Number; }
+    JType Type() const { return JType::Number; }
+
+    prop* clone() const { return new Num(*this); }
 
     T value;
 };
@@ -189,19 +558,28 @@ struct Num: prop{
 struct Str: prop{
 
     Str(const std::string& name,
-        const std::string &val):prop(name),value(val){}
+        const std::string &val):prop(name, Kind::String),value(val){}
 
-    Str(const std::string& val):value(val){}
+    Str():prop(Kind::String){}
 
-    std::string getStr(){
+    Str(const std::string& val):prop(Kind::String),value(val){}
+
+    std::string getStr() const {
         return value;
     }
 
     std::string toStr() const {
-        return enclose(m_name)+": "+enclose(value);
+        return named(m_name)+enclose(value);
+    }
+
+    void set(const std::string& val){
+        value=val;
+        touch();
     }
 
-    JType Type(){ return JType::String; }
+    JType Type() const { return JType::String; }
+
+    prop* clone() const { return new Str(*this); }
 
     std::string value;
 };
@@ -209,32 +587,43 @@ struct Str: prop{
 struct Boo: prop{
 
     Boo(const std::string& name,
-        bool val):prop(name),value(val){}
+        bool val):prop(name, Kind::Bool),value(val){}
 
-    Boo(bool val):value(val){}
+    Boo():prop(Kind::Bool),value(false){}
 
-    bool getBool(){
+    Boo(bool val):prop(Kind::Bool),value(val){}
+
+    bool getBool() const {
         return value;
     }
 
     std::string toStr() const {
-        return enclose(m_name)+": "+(value?"True":"False");
+        return named(m_name)+(value?"true":"false");
+    }
+
+    void set(bool val){
+        value=val;
+        touch();
     }
 
-    JType Type(){ return JType::Bool; }
+    JType Type() const { return JType::Bool; }
+
+    prop* clone() const { return new Boo(*this); }
 
     bool value;
 };
 
 struct Nul: prop{
 
-    Nul(){}
+    Nul():prop(Kind::Null){}
 
     std::string toStr() const {
-        return enclose(m_name)+": Null";
+        return named(m_name)+"null";
     }
 
-    JType Type(){ return JType::Null; }
+    JType Type() const { return JType::Null; }
+
+    prop* clone() const { return new Nul(*this); }
 
 };
 /* this is used when Null array is encountered */
@@ -242,15 +631,23 @@ struct Null_val {
 
 };
 
+struct Obj;
+
+template <> struct kind_of<Null_val>{ static const Kind arr=Kind::ArrNull; };
+template <> struct kind_of<Obj*>{ static const Kind arr=Kind::ArrObject; };
+template <> struct kind_of<prop*>{ static const Kind arr=Kind::ArrAny; };
+
 template <typename T>
 struct Arr: prop{
 
-    Arr(std::vector<T> val):value(val){}
+    Arr():prop(kind_of<T>::arr){}
+
+    Arr(std::vector<T> val):prop(kind_of<T>::arr),value(val){}
 
     ~Arr(){}
 
     std::string toStr() const {
-        std::string res=enclose(m_name)+": ";
+        std::string res=named(m_name);
 
         res+="[ ";
 
@@ -263,14 +660,57 @@ struct Arr: prop{
         return res;
     }
 
-    JType Type(){ return JType::Array; }
+    JType Type() const { return JType::Array; }
+
+    prop* clone() const { return new Arr(*this); }
+
+    /* appends toStr(), or text kept from the last write
+     * if value wasn't touched since, see Obj::keepFragments */
+    void write(std::string& out) const {
+
+        if (m_keep&&m_clean){
+            out+=m_cache;
+            return;
+        }
+
+        size_t start=out.size();
+
+        out+=toStr();
+
+        if (m_keep){
+            m_cache.assign(out, start, string::npos);
+            m_clean=true;
+        }
+    }
+
+    void dirty() const {
+        m_clean=false;
+    }
+
+    void keep() const {
+        m_keep=true;
+    }
+
+    void detach() const {
+        m_parent=nullptr;
+        m_keep=false;
+        m_clean=false;
+        std::string().swap(m_cache);
+    }
 
     std::vector<T> value;
+
+private:
+
+    /* serialized text, valid while m_clean */
+    mutable std::string m_cache;
+    mutable bool m_clean{false};
+    mutable bool m_keep{false};
 };
 
 template <>
 string Arr<string>::toStr() const {
-    std::string res=enclose(m_name)+": ";
+    std::string res=named(m_name);
 
     res+="[ ";
 
@@ -285,7 +725,7 @@ string Arr<string>::toStr() const {
 
 template <>
 string Arr<bool>::toStr() const {
-    std::string res=enclose(m_name)+": ";
+    std::string res=named(m_name);
 
     res+="[ ";
 
@@ -302,22 +742,22 @@ string Arr<bool>::toStr() const {
 
 template <>
 string Arr<Null_val>::toStr() const {
-    std::string res=enclose(m_name)+": ";
+    std::string res=named(m_name);
 
     res+="[ ";
 
     for (size_t i=0;i<value.size()-1;++i)
-        res+="Null, ";
+        res+="null, ";
 
 
-    res+="Null ]";
+    res+="null ]";
 
     return res;
 }
 
 template <>
 string Arr<double>::toStr() const {
-    std::string res=enclose(m_name)+": ";
+    std::string res=named(m_name);
 
     res+="[ ";
 
@@ -344,7 +784,7 @@ string Arr<double>::toStr() const {
 
 template <>
 string Arr<long double>::toStr() const {
-    std::string res=enclose(m_name)+": ";
+    std::string res=named(m_name);
 
     res+="[ ";
 
@@ -364,34 +804,39 @@ string Arr<long double>::toStr() const {
 
 struct Obj: prop{
 
-    Obj(){}
+    Obj():prop(Kind::Object){}
 
-    Obj(const std::string& name):prop(name){}
+    Obj(const std::string& name):prop(name, Kind::Object){}
 
     void addProperty(const std::string& name, const int& value){
         prop* ptr=new Num<int>(name, value);
         props.push_back(ptr);
+        touch();
     }
 
     void addProperty(const std::string& name, const double& value){
         prop* ptr=new Num<double>(name, value);
         props.push_back(ptr);
+        touch();
     }
 
     void addProperty(const std::string& name, char * const value){
         prop* ptr=new Str(name, value);
         props.push_back(ptr);
+        touch();
     }
 
     void addProperty(const std::string& name, bool value){
         prop* ptr=new Boo(name, value);
         props.push_back(ptr);
+        touch();
     }
 
     template <typename T>
     void addProperty(const std::string& name, const std::vector<T>& tmp){
         prop* ptr=new Arr<T>(tmp);
         props.push_back(ptr);
+        touch();
     }
 
     void addObject(const std::string& json){
@@ -400,6 +845,7 @@ struct Obj: prop{
         ptr->Parse(json);
 
         props.push_back(ptr);
+        touch();
     }
 
     void addObject(Obj& op2){
@@ -420,156 +866,191 @@ struct Obj: prop{
                 return *x;
     }
 
-    std::string toStr() const {
-        std::string res;
+    const prop* findProperty(const std::string& name) const {
+        for (auto x: props)
+            if (x->m_name==name)
+                return x;
 
-        if (!m_name.empty()){
-            res=enclose(m_name)+": {";
-        } else res="{";
+        return nullptr;
+    }
 
-        for (size_t i=0;i<props.size()-1;++i){
-            res+=props[i]->toStr()+", ";
-        }
+    const prop& operator[](const std::string& name) const {
+        const prop* res=findProperty(name);
 
-        res+=props[props.size()-1]->toStr()+"}";
+        if (!res)
+            throw std::out_of_range("no property "+name);
 
-        return res;
+        return *res;
     }
 
-    void Parse(const string& input){
-
-        size_t delim=input.find(':');
-        size_t left=input.find('{');
-        size_t right;
+    std::string toStr() const {
+        std::string res;
 
-        if (left<delim){
+        write(res);
 
-            delim=0;
-        } else {
+        return res;
+    }
 
-            right=input.rfind('"', delim);
-            left=input.rfind('"', right-1);
+    void write(std::string& res) const {
 
-            if (left!=string::npos&&right!=string::npos)
-                m_name=input.substr(left+1, right-left-1);
+        if (m_keep&&m_clean){
+            res+=m_cache;
+            return;
         }
 
-//        cout << "Object: " << m_name << endl;
+        size_t start=res.size();
 
-        /* name of next property */
-        string child_name;
+        if (!m_name.empty()){
+            res+=enclose(m_name)+": {";
+        } else res+="{";
 
-        /* value of next property */
-        string val;
+        for (size_t i=0;i<props.size();++i){
 
-        for (;;){
+            if (m_keep){
+                props[i]->m_parent=this;
+                props[i]->keep();
+            }
 
-            delim=input.find(':', delim+1);
+            if (i)
+                res+=", ";
 
-            right=input.rfind('"', delim);
-            left=input.rfind('"', right-1);
+            /* empty key, not an array element */
+            if (props[i]->m_name.empty())
+                res+="\"\": ";
 
-            child_name=input.substr(left+1, right-left-1);
+            props[i]->write(res);
+        }
 
-            right=input.find_first_of(",}", delim);
+        res+="}";
 
-            if (right==string::npos){
-                break;
-            }
+        if (m_keep){
+            m_cache.assign(res, start, string::npos);
+            m_clean=true;
+        }
+    }
 
-//            cout << "child_name: " << child_name << endl;
+    /* Keeps serialized text of this object and of nested ones,
+     * so toStr() copies unchanged subtrees and encodes again only
+     * the ones changed by adders, setters or touch() since */
+    void keepFragments(bool on=true){
+        m_keep=on;
+        m_clean=false;
+    }
 
-            prop* child=nullptr;
+    void Parse(const string& input){
 
-            JType t=detect_val_type(input, delim+1);
+        touch();
 
-            if (t==JType::Array){
+        m_slot=nullptr;
 
-//                cout << "Parsing Array" << endl;
+        parse_obj(input, 0, input.size());
+    }
 
-                left=input.find('[', delim);
+    /* Parse with shape cache: when input has the layout remembered
+     * in shape it is parsed directly, otherwise falls back to
+     * Parse(input) and shape is recorded again */
+    void Parse(const string& input, Shape& shape){
 
-                right=Hlp::detect_closing_bracket(input, left+1, '[', ']');
+        touch();
 
-                if (right==string::npos){
-                    throw std::logic_error("'[' not closed "+std::to_string(left));
-                }
+        if (!shape.empty()){
+            size_t pos=0;
 
-//                cout << "val: " << input.substr(left, right-left+1) << endl;
-                child=parse_arr(input.substr(left, right-left+1));
+            if (parse_shaped(input, pos, shape))
+                return;
+        }
 
-                delim=right;
-            } else if (t==JType::Bool){
+        Parse(input);
 
-//                cout << "Parsing Bool" << endl;
+        shape.clear();
+        record(shape);
+    }
 
-                char c=input[input.find_first_of("tfTF", delim)];
-//                cout << "val: " << (c=='t'||c=='T'?"True":"False") << endl;
-                child=new Boo((c=='t'||c=='T')?true:false);
+    /* Parse only members on paths from proj */
+    void Parse(const string& input, const Projection& proj){
+        size_t pos=0;
 
-            } else if (t==JType::Null){
+        touch();
 
-//                cout << "Parsing Null" << endl;
+        parse_projected(input, pos, proj, 0);
+    }
 
-                child=new Nul();
+    /* stores layout of this object into shape */
+    void record(Shape& shape) const {
+        for (auto x: props){
+            Shape::slot s;
 
-            } else if (t==JType::Number){
+            s.key=x->m_name;
+            s.type=x->Type();
+            s.ntype=num_type(x);
 
-//                cout << "Parsing number" << endl;
+            if (s.type==JType::Object){
+                s.sub.resize(1);
+                ((Obj*)x)->record(s.sub[0]);
+            }
 
-                left=input.find_first_of("-1234567890", delim);
-                right=input.find_first_not_of("-1234567890.eE", left);
+            shape.slots.push_back(s);
+        }
+    }
 
-//                cout << "val: " << input.substr(left, right-left) << endl;
-                child=parse_num(input.substr(left, right-left));
+    /* Prepares object for the next Parse keeping its nodes, props
+     * capacity and string buffers. Nodes are reused by the next
+     * Parse for properties of the same type at the same position,
+     * the ones left unused are freed at its end */
+    void reset(){
+        touch();
+        release();
 
-            } else if (t==JType::Object){
+        for (auto x: props)
+            reset_node(x);
 
-//                cout << "Parsing object" << endl;
+        spare.swap(props);
+        props.clear();
+        m_name.clear();
+        m_slot=nullptr;
+    }
 
-                left=input.find('{', delim);
-                right=Hlp::detect_closing_bracket(input, left+1);
+    bool empty(){
+        return (props.empty()&&m_name.empty());
+    }
 
-                child=new Obj();
+    void memfree(){
+        for (auto x: props){
+            if (x->Type()==JType::Object)
+                ((Obj*)x)->memfree();
 
-                ((Obj*)child)->Parse(input.substr(left, right-left+1));
+            delete x;
+        }
 
-            } else if (t==JType::String){
+        release();
+    }
 
-//                cout << "Parsing string" << endl;
+    JType Type() const { return JType::Object; }
 
-                left=input.find('"', delim);
-                right=input.find('"', left+1);
+    prop* clone() const {
+        Obj* res=new Obj(m_name);
 
-                val=input.substr(left+1, right-left-1);
-//                cout << "val: " << val << endl;
+        res->props.reserve(props.size());
 
-                child=new Str(val);
-            }
+        for (auto x: props)
+            res->props.push_back(x->clone());
 
-            if (child){
-                child->m_name=child_name;
-                props.push_back(child);
-            }
-        }
+        return res;
     }
 
-    bool empty(){
-        return (props.empty()&&m_name.empty());
+    std::vector<prop*>::iterator begin() {
+        return props.begin();
     }
 
-    void memfree(){
-        for (auto x: props)
-            delete x;
+    std::vector<prop*>::iterator end() {
+        return props.end();
     }
 
-    JType Type(){ return JType::Object; }
-
-    std::vector<prop*>::iterator begin() {
+    std::vector<prop*>::const_iterator begin() const {
         return props.begin();
     }
 
-    std::vector<prop*>::iterator end() {
+    std::vector<prop*>::const_iterator end() const {
         return props.end();
     }
 
@@ -579,324 +1060,3574 @@ struct Obj: prop{
 
     std::vector<prop*> props;
 
-private:
+    void dirty() const {
+        m_clean=false;
+    }
 
-    prop* parse_num(const string& input){
+    void keep() const {
+        m_keep=true;
+    }
 
-        NType nt=detect_num_type(input);
+    void detach() const {
+        m_parent=nullptr;
+        m_keep=false;
+        m_clean=false;
+        std::string().swap(m_cache);
 
-        switch (nt) {
-        case NType::i32:
-            return new Num<int32_t>(std::stol(input));
-            break;
-        case NType::i64:
-            return new Num<int64_t>(std::stoll(input));
+        for (auto x: props)
+            x->detach();
+    }
+
+private:
+
+    /* serialized text, valid while m_clean */
+    mutable std::string m_cache;
+    mutable bool m_clean{false};
+    mutable bool m_keep{false};
+
+    /* nodes of the previous parse kept by reset() */
+    std::vector<prop*> spare;
+
+    /* node to be reused by the next make, see parse_arr */
+    prop** m_slot{nullptr};
+
+    static NType num_type(prop* p){
+        if (dynamic_cast<Num<int64_t>*>(p))
+            return NType::i64;
+        else if (dynamic_cast<Num<double>*>(p))
+            return NType::d;
+        else if (dynamic_cast<Num<long double>*>(p))
+            return NType::ld;
+
+        return NType::i32;
+    }
+
+    /* resets objects in p, which are kept with it */
+    static void reset_node(prop* p){
+        /* reused arrays must not write text of the previous parse */
+        p->dirty();
+
+        switch (p->m_kind) {
+        case Kind::Object:
+            ((Obj*)p)->reset();
             break;
-        case NType::d:
-            return new Num<double>(std::stod(input));
+        case Kind::ArrObject:
+            for (auto x: ((Arr<Obj*>*)p)->value)
+                x->reset();
             break;
-        case NType::ld:
-            return new Num<long double>(std::stold(input));
+        case Kind::ArrAny:
+            for (auto x: ((Arr<prop*>*)p)->value)
+                reset_node(x);
+            break;
+        default:
+            break;
+        }
+    }
+
+    static void drop(prop* p){
+        if (p->Type()==JType::Object)
+            ((Obj*)p)->memfree();
+
+        delete p;
+    }
+
+    /* returns node for the next property, taking the one kept by
+     * reset() at the same position if it is of the same type.
+     * For array elements m_slot points to the old element instead */
+    template <typename T>
+    T* make(){
+        prop** slot=m_slot;
+
+        m_slot=nullptr;
+
+        if (!slot&&props.size()<spare.size())
+            slot=&spare[props.size()];
+
+        if (slot&&*slot){
+            T* res=dynamic_cast<T*>(*slot);
+
+            if (res){
+                *slot=nullptr;
+                return res;
+            }
+        }
+
+        return new T();
+    }
+
+    template <typename T>
+    Num<T>* make_num(T val){
+        Num<T>* res=make<Num<T>>();
+        res->value=val;
+        return res;
+    }
+
+    Boo* make_boo(bool val){
+        Boo* res=make<Boo>();
+        res->value=val;
+        return res;
+    }
+
+    /* frees nodes kept by reset() which were not reused */
+    void release(){
+        for (auto x: spare)
+            if (x)
+                drop(x);
+
+        spare.clear();
+    }
+
+    /* removes properties added by failed parse_shaped */
+    bool unwind(size_t first){
+        for (size_t i=first;i<props.size();++i)
+            drop(props[i]);
+
+        props.resize(first);
+
+        return false;
+    }
+
+    /* parses object starting at pos with layout from shape,
+     * returns false if input doesn't match it */
+    bool parse_shaped(const string& input, size_t& pos, const Shape& shape){
+
+        size_t first=props.size();
+
+        pos=Hlp::skip_ws(input, pos);
+
+        if (input[pos]!='{')
+            return false;
+
+        pos=Hlp::skip_ws(input, pos+1);
+
+        for (size_t i=0;i<shape.slots.size();++i){
+
+            const Shape::slot& s=shape.slots[i];
+
+            if (i>0){
+                if (input[pos]!=',')
+                    return unwind(first);
+
+                pos=Hlp::skip_ws(input, pos+1);
+            }
+
+            if (!Hlp::match_key(input, pos, s.key))
+                return unwind(first);
+
+            prop* child=parse_slot(input, pos, s);
+
+            if (!child)
+                return unwind(first);
+
+            child->m_name=s.key;
+            props.push_back(child);
+
+            pos=Hlp::skip_ws(input, pos);
+        }
+
+        if (input[pos]!='}')
+            return unwind(first);
+
+        ++pos;
+
+        release();
+
+        return true;
+    }
+
+    /* parses value at pos expecting type from slot */
+    prop* parse_slot(const string& input, size_t& pos, const Shape::slot& s){
+
+        char c=input[pos];
+        size_t right;
+
+        switch (s.type) {
+        case JType::String:
+
+            if (c!='"')
+                return nullptr;
+
+            right=input.find('"', pos+1);
+
+            if (right==string::npos)
+                return nullptr;
+
+            {
+                Str* res=make<Str>();
+                res->value.assign(input, pos+1, right-pos-1);
+                pos=right+1;
+                return res;
+            }
+
+        case JType::Bool:
+
+            if (c=='t'&&input.compare(pos, 4, "true")==0){
+                pos+=4;
+                return make_boo(true);
+            } else if (c=='f'&&input.compare(pos, 5, "false")==0){
+                pos+=5;
+                return make_boo(false);
+            }
+
+            return nullptr;
+
+        case JType::Null:
+
+            if (c!='n'||input.compare(pos, 4, "null")!=0)
+                return nullptr;
+
+            pos+=4;
+            return make<Nul>();
+
+        case JType::Number:
+
+            if (c!='-'&&!::isdigit(c))
+                return nullptr;
+
+            {
+                bool real=false;
+                right=Hlp::number_end(input, pos, real);
+
+                return parse_slot_num(input, pos, right, real, s.ntype);
+            }
+
+        case JType::Array:
+
+            if (c!='[')
+                return nullptr;
+
+            right=Hlp::detect_closing_bracket(input, pos+1, '[', ']');
+
+            if (right==string::npos)
+                return nullptr;
+
+            {
+                prop* res=parse_arr(input, pos, right);
+                pos=right+1;
+                return res;
+            }
+
+        case JType::Object:
+
+            if (c!='{')
+                return nullptr;
+
+            {
+                Obj* res=make<Obj>();
+
+                if (!res->parse_shaped(input, pos, s.sub[0])){
+                    drop(res);
+                    return nullptr;
+                }
+
+                return res;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /* parses object at pos keeping members found under node n of proj */
+    void parse_projected(const string& input, size_t& pos, const Projection& proj, size_t n){
+
+        pos=Hlp::skip_ws(input, pos);
+
+        if (input[pos]!='{')
+            throw std::logic_error("'{' expected "+std::to_string(pos));
+
+        pos=Hlp::skip_ws(input, pos+1);
+
+        while (input[pos]!='}'){
+
+            if (input[pos]!='"')
+                throw std::logic_error("key expected "+std::to_string(pos));
+
+            size_t left=pos+1;
+            size_t right=Hlp::skip_value(input, pos)-1;
+
+            pos=Hlp::skip_ws(input, right+1);
+
+            if (input[pos]!=':')
+                throw std::logic_error("':' expected "+std::to_string(pos));
+
+            pos=Hlp::skip_ws(input, pos+1);
+
+            size_t m=proj.find(n, input.c_str()+left, right-left);
+
+            prop* child=nullptr;
+
+            if (m&&proj.nodes[m].leaf){
+
+                child=parse_value(input, pos);
+
+            } else if (m&&input[pos]=='{'){
+
+                Obj* obj=make<Obj>();
+
+                obj->parse_projected(input, pos, proj, m);
+
+                if (obj->props.empty())
+                    drop(obj);
+                else child=obj;
+
+            } else pos=Hlp::skip_value(input, pos);
+
+            if (child){
+                child->m_name.assign(input, left, right-left);
+                props.push_back(child);
+            }
+
+            pos=Hlp::skip_ws(input, pos);
+
+            if (input[pos]==',')
+                pos=Hlp::skip_ws(input, pos+1);
+            else if (input[pos]!='}')
+                throw std::logic_error("',' or '}' expected "+std::to_string(pos));
+        }
+
+        ++pos;
+
+        release();
+    }
+
+    /* generic Parse of object input[begin, end) */
+    void parse_obj(const string& input, size_t begin, size_t end){
+
+        size_t delim=input.find(':', begin);
+        size_t left=input.find('{', begin);
+        size_t right;
+
+        if (left<delim){
+
+            delim=left;
+        } else {
+
+            right=input.rfind('"', delim);
+            left=input.rfind('"', right-1);
+
+            if (left!=string::npos&&right!=string::npos)
+                m_name=input.substr(left+1, right-left-1);
+        }
+
+        /* name of next property is input[name_left, name_right) */
+        size_t name_left, name_right;
+
+        for (;;){
+
+            delim=input.find(':', delim+1);
+
+            if (delim>=end)
+                break;
+
+            name_right=input.rfind('"', delim);
+            name_left=input.rfind('"', name_right-1)+1;
+
+            right=input.find_first_of(",}", delim);
+
+            if (right>=end){
+                break;
+            }
+
+            prop* child=nullptr;
+
+            JType t=detect_val_type(input, delim+1);
+
+            if (t==JType::Array){
+
+                left=input.find('[', delim);
+
+                right=Hlp::detect_closing_bracket(input, left+1, '[', ']');
+
+                if (right==string::npos){
+                    throw std::logic_error("'[' not closed "+std::to_string(left));
+                }
+
+                child=parse_arr(input, left, right);
+
+                delim=right;
+            } else if (t==JType::Bool){
+
+                char c=input[input.find_first_of("tfTF", delim)];
+                child=make_boo((c=='t'||c=='T')?true:false);
+
+            } else if (t==JType::Null){
+
+                child=make<Nul>();
+
+            } else if (t==JType::Number){
+
+                left=input.find_first_of("-1234567890", delim);
+                right=input.find_first_not_of("-1234567890.eE", left);
+
+                child=parse_num(input.substr(left, right-left));
+
+            } else if (t==JType::Object){
+
+                left=input.find('{', delim);
+                right=Hlp::detect_closing_bracket(input, left+1);
+
+                child=make<Obj>();
+
+                ((Obj*)child)->parse_obj(input, left, right+1);
+
+                delim=right;
+
+            } else if (t==JType::String){
+
+                left=input.find('"', delim);
+                right=input.find('"', left+1);
+
+                Str* str=make<Str>();
+
+                str->value.assign(input, left+1, right-left-1);
+
+                child=str;
+
+                delim=right;
+            }
+
+            if (child){
+                child->m_name.assign(input, name_left, name_right-name_left);
+                props.push_back(child);
+            }
+        }
+
+        release();
+    }
+
+    /* parses any value at pos and moves pos after it */
+    prop* parse_value(const string& input, size_t& pos){
+
+        size_t right=Hlp::skip_value(input, pos);
+
+        prop* res=nullptr;
+
+        switch (detect_val_type(input, pos)) {
+        case JType::String:
+            res=make<Str>();
+            ((Str*)res)->value.assign(input, pos+1, right-pos-2);
             break;
+        case JType::Bool:
+            res=make_boo(input[pos]=='t');
+            break;
+        case JType::Null:
+            res=make<Nul>();
+            break;
+        case JType::Number:
+            res=parse_num(input.substr(pos, right-pos));
+            break;
+        case JType::Array:
+            res=parse_arr(input, pos, right-1);
+            break;
+        case JType::Object:
+            res=make<Obj>();
+            ((Obj*)res)->parse_obj(input, pos, right);
+            break;
+        }
+
+        pos=right;
+
+        return res;
+    }
+
+    prop* parse_slot_num(const string& input, size_t& pos, size_t right, bool real, NType nt){
+
+        const char* b=input.c_str()+pos;
+        size_t len=right-pos;
+
+        prop* res=nullptr;
+
+        if (nt==NType::i32||nt==NType::i64){
+
+            if (real||(nt==NType::i32)!=Hlp::fits_int32(b, b+len))
+                return nullptr;
+
+            if (nt==NType::i32)
+                res=make_num<int32_t>(Hlp::parse_int(b, b+len));
+            else res=make_num<int64_t>(Hlp::parse_int(b, b+len));
+
+        } else {
+
+            /* same as detect_num_type without copying the number,
+             * long double is needed only when double gives max */
+            if (!real)
+                return nullptr;
+
+            double val=std::strtod(b, nullptr);
+            NType t=NType::d;
+
+            if (val==std::numeric_limits<double>::max()&&std::strtold(b, nullptr)==val)
+                t=NType::ld;
+
+            if (t!=nt)
+                return nullptr;
+
+            if (nt==NType::d)
+                res=make_num<double>(val);
+            else res=make_num<long double>(std::strtold(b, nullptr));
         }
+
+        pos=right;
+
+        return res;
     }
 
-    prop* parse_arr(const string& input){
+    prop* parse_num(const string& input){
+
+        NType nt=detect_num_type(input);
+
+        switch (nt) {
+        case NType::i32:
+            return make_num<int32_t>(std::stol(input));
+            break;
+        case NType::i64:
+            return make_num<int64_t>(std::stoll(input));
+            break;
+        case NType::d:
+            return make_num<double>(std::stod(input));
+            break;
+        case NType::ld:
+            return make_num<long double>(std::stold(input));
+            break;
+        }
+    }
+
+    template <typename T>
+    Arr<T>* make_arr(size_t count){
+        Arr<T>* res=make<Arr<T>>();
+        res->value.clear();
+        res->value.reserve(count);
+        return res;
+    }
+
+    /* parses array input[left..right] where input[right] is its ']'.
+     * Arrays of one type go to Arr of that type, numbers are
+     * converted in place with width picked like detect_num_type.
+     * Nested and mixed arrays are kept as Arr<prop*> */
+    prop* parse_arr(const string& input, size_t left, size_t right){
+
+        using std::vector;
+
+        /* first pass finds type of elements without converting */
+
+        size_t count=0;
+        bool mixed=false;
+        JType type=JType::Null;
+        NType arr_nt=NType::i32;
+
+        for (size_t p=Hlp::skip_ws(input, left+1);p<right;){
+
+            char c=input[p];
+            JType t;
+
+            if (c=='"')
+                t=JType::String;
+            else if (c=='t'||c=='f')
+                t=JType::Bool;
+            else if (c=='n')
+                t=JType::Null;
+            else if (c=='-'||::isdigit(c))
+                t=JType::Number;
+            else if (c=='[')
+                t=JType::Array;
+            else if (c=='{')
+                t=JType::Object;
+            else throw std::logic_error("unexpected '"+string(1, c)+"' in array "+std::to_string(p));
+
+            size_t e;
+
+            if (t==JType::Number){
+                bool real=false;
+
+                e=Hlp::number_end(input, p, real);
+
+                if (real)
+                    arr_nt=std::max(arr_nt, NType::d);
+                else if (!Hlp::fits_int32(input.c_str()+p, input.c_str()+e))
+                    arr_nt=std::max(arr_nt, NType::i64);
+
+            } else e=Hlp::skip_value(input, p);
+
+            if (count==0)
+                type=t;
+            else if (t!=type)
+                mixed=true;
+
+            ++count;
+
+            p=Hlp::skip_ws(input, e);
+
+            if (input[p]==',')
+                p=Hlp::skip_ws(input, p+1);
+        }
+
+        size_t p=Hlp::skip_ws(input, left+1);
+
+        /* moves p to the next element */
+        auto next=[&](size_t e){
+            p=Hlp::skip_ws(input, e);
+
+            if (input[p]==',')
+                p=Hlp::skip_ws(input, p+1);
+        };
+
+        if (count==0||mixed||type==JType::Array){
+
+            Arr<prop*>* res=make<Arr<prop*>>();
+
+            /* elements of reused array are reused in place */
+            size_t n=res->value.size(), i=0;
+
+            for (;p<right;++i){
+                prop* old=(i<n)?res->value[i]:nullptr;
+
+                m_slot=&old;
+
+                prop* x=parse_value(input, p);
+
+                if (old)
+                    drop(old);
+
+                x->m_name.clear();
+
+                if (i<n)
+                    res->value[i]=x;
+                else res->value.push_back(x);
+
+                next(p);
+            }
+
+            for (size_t k=i;k<n;++k)
+                drop(res->value[k]);
+
+            res->value.resize(i);
+
+            return res;
+
+        } else if (type==JType::String){
+
+            Arr<string>* res=make<Arr<string>>();
+            res->value.resize(count);
+
+            for (size_t i=0;p<right;++i){
+                size_t e=Hlp::skip_value(input, p);
+                res->value[i].assign(input, p+1, e-p-2);
+                next(e);
+            }
+
+            return res;
+        } else if (type==JType::Bool){
+
+            Arr<bool>* res=make_arr<bool>(count);
+
+            while (p<right){
+                res->value.push_back(input[p]=='t');
+                next(Hlp::skip_value(input, p));
+            }
+
+            return res;
+        } else if (type==JType::Null){
+
+            Arr<Null_val>* res=make<Arr<Null_val>>();
+            res->value.resize(count);
+            return res;
+        } else if (type==JType::Number){
+
+            const char* d=input.c_str();
+
+            if (arr_nt==NType::i32){
+                Arr<int32_t>* res=make_arr<int32_t>(count);
+
+                while (p<right){
+                    bool real;
+                    size_t e=Hlp::number_end(input, p, real);
+                    res->value.push_back(Hlp::parse_int(d+p, d+e));
+                    next(e);
+                }
+
+                return res;
+            } else if (arr_nt==NType::i64){
+                Arr<int64_t>* res=make_arr<int64_t>(count);
+
+                while (p<right){
+                    bool real;
+                    size_t e=Hlp::number_end(input, p, real);
+                    res->value.push_back(Hlp::parse_int(d+p, d+e));
+                    next(e);
+                }
+
+                return res;
+            }
+
+            Arr<double>* res=make_arr<double>(count);
+            size_t first=p;
+
+            while (p<right){
+                char* e;
+                res->value.push_back(std::strtod(d+p, &e));
+                next(e-d);
+
+                /* too big for double, see detect_num_type */
+                if (res->value.back()==std::numeric_limits<double>::max())
+                    break;
+            }
+
+            if (p>=right)
+                return res;
+
+            delete res;
+
+            Arr<long double>* ld=new Arr<long double>();
+            ld->value.reserve(count);
+
+            for (p=first;p<right;){
+                char* e;
+                ld->value.push_back(std::strtold(d+p, &e));
+                next(e-d);
+            }
+
+            return ld;
+
+        } else {
+
+            Arr<Obj*>* res=make<Arr<Obj*>>();
+
+            /* objects of reused array were reset with it */
+            size_t n=res->value.size(), i=0;
+
+            for (;p<right;++i){
+                size_t e=Hlp::skip_value(input, p);
+
+                if (i>=n)
+                    res->value.push_back(new Obj());
+
+                res->value[i]->parse_obj(input, p, e);
+
+                next(e);
+            }
+
+            for (size_t k=i;k<n;++k)
+                drop(res->value[k]);
+
+            res->value.resize(i);
+
+            return res;
+        }
+    }
+};
+
+template <>
+string Arr<Obj*>::toStr() const {
+    std::string res=named(m_name);
+
+    res+="[ ";
+
+    for (size_t i=0;i<value.size()-1;++i){
+        value[i]->write(res);
+
+        res+=", ";
+    }
+
+    value[value.size()-1]->write(res);
+    res+=" ]";
+
+    return res;
+}
+
+template <>
+void Arr<Obj*>::keep() const {
+    m_keep=true;
+
+    for (auto x: value){
+        x->m_parent=this;
+        x->keep();
+    }
+}
+
+template <>
+void Arr<Obj*>::detach() const {
+    m_parent=nullptr;
+    m_keep=false;
+    m_clean=false;
+    std::string().swap(m_cache);
+
+    for (auto x: value)
+        x->detach();
+}
+
+template <>
+Arr<Obj*>::~Arr(){
+    for (auto x: value){
+        x->memfree();
+        delete x;
+    }
+}
+
+template <>
+prop* Arr<Obj*>::clone() const {
+    Arr<Obj*>* res=new Arr<Obj*>();
+
+    res->m_name=m_name;
+
+    for (auto x: value)
+        res->value.push_back((Obj*)x->clone());
+
+    return res;
+}
+
+template <>
+string Arr<prop*>::toStr() const {
+    std::string res=named(m_name);
+
+    if (value.empty())
+        return res+"[]";
+
+    res+="[ ";
+
+    for (size_t i=0;i<value.size()-1;++i){
+        value[i]->write(res);
+        res+=", ";
+    }
+
+    value[value.size()-1]->write(res);
+    res+=" ]";
+
+    return res;
+}
+
+template <>
+void Arr<prop*>::keep() const {
+    m_keep=true;
+
+    for (auto x: value){
+        x->m_parent=this;
+        x->keep();
+    }
+}
+
+template <>
+void Arr<prop*>::detach() const {
+    m_parent=nullptr;
+    m_keep=false;
+    m_clean=false;
+    std::string().swap(m_cache);
+
+    for (auto x: value)
+        x->detach();
+}
+
+template <>
+prop* Arr<prop*>::clone() const {
+    Arr<prop*>* res=new Arr<prop*>();
+
+    res->m_name=m_name;
+
+    for (auto x: value)
+        res->value.push_back(x->clone());
+
+    return res;
+}
+
+template <>
+Arr<prop*>::~Arr(){
+    for (auto x: value){
+        if (x->Type()==JType::Object)
+            ((Obj*)x)->memfree();
+
+        delete x;
+    }
+}
+
+/* Main Object (Document) */
+
+struct JSON{
+
+    JSON(){}
+
+    JSON(const std::string& name):m_obj(name){}
+
+    ~JSON(){
+        m_obj.memfree();
+    }
+
+    /* keeps nodes and buffers of the document for the next Parse,
+     * see Obj::reset */
+    void reset(){
+        m_obj.reset();
+    }
+
+    void Parse(const std::string& input){
+        m_obj.Parse(input);
+    }
+
+    /* Parse only members on paths from proj, see Projection */
+    void Parse(const std::string& input, const Projection& proj){
+        m_obj.Parse(input, proj);
+    }
+
+    /* Parse reusing layout of previous records, see Shape */
+    void Parse(const std::string& input, Shape& shape){
+        m_obj.Parse(input, shape);
+    }
+
+    prop& operator[](const std::string& name){
+        return m_obj[name];
+    }
+
+    Obj findObj(const std::string& name){
+        if (name==m_obj.m_name)
+            return m_obj;
+
+        for (auto x: m_obj.props){
+            if (x->m_name==name){
+                return *dynamic_cast<Obj*>(x);
+            }
+        }
+
+        return Obj();
+    }
+
+    void addProperty(const std::string& name, const int& value){
+        prop* ptr=new Num<double>(name, value);
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    void addProperty(const std::string& name, const double& value){
+        prop* ptr=new Num<double>(name, value);
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    void addProperty(const std::string& name, const int64_t& value){
+        prop* ptr=new Num<int64_t>(name, value);
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    void addProperty(const std::string& name, const long double& value){
+        prop* ptr=new Num<long double>(name, value);
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    void addProperty(const std::string& name, char * const value){
+        prop* ptr=new Str(name, value);
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    void addProperty(const std::string& name, bool value){
+        prop* ptr=new Boo(name, value);
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    template <typename T>
+    void addProperty(const std::string& name, const std::vector<T>& tmp){
+        prop* ptr=new Arr<T>(tmp);
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    /* Add object in text representation */
+
+    void addObject(const std::string& json){
+        Obj* ptr=new Obj();
+
+        ptr->Parse(json);
+
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    /* op2 should be const but
+     * toStr is not working */
+
+    void addObject(const Obj& op2){
+        Obj *ptr=new Obj();
+
+        ptr->Parse(op2.toStr());
+
+        m_obj.props.push_back(ptr);
+        m_obj.touch();
+    }
+
+    std::string toStr() const {
+        return m_obj.toStr();
+    }
+
+    /* see Obj::keepFragments */
+    void keepFragments(bool on=true){
+        m_obj.keepFragments(on);
+    }
+
+    const Obj& root() const {
+        return m_obj;
+    }
+
+    std::vector<prop*>::iterator begin(){
+        return m_obj.begin();
+    }
+
+    std::vector<prop*>::iterator end(){
+        return m_obj.end();
+    }
+
+private:
+    Obj m_obj;
+};
+
+struct Jiter{
+
+    Jiter()=default;
+
+    Jiter(std::vector<prop*>::iterator op2){
+        it=op2;
+    }
+
+    Jiter& operator=(std::vector<prop*>::iterator op2){
+        it=op2;
+        return *this;
+    }
+
+    Jiter& operator=(const Jiter& op2){
+        it=op2.it;
+        return *this;
+    }
+
+    Jiter& operator++(){
+        ++it;
+        return *this;
+    }
+
+    prop* operator->(){
+        return (*it);
+    }
+
+    bool operator==(const Jiter& op2){
+        return it==op2.it;
+    }
+
+    bool operator!=(const Jiter& op2){
+        return it!=op2.it;
+    }
+
+    Obj* getObj(){
+        return dynamic_cast<Obj*>(*it);
+    }
+
+    bool isNull(){
+        return (*it)==nullptr;
+    }
+
+private:
+    std::vector<prop*>::iterator it;
+};
+
+/* Cursor points to a value in the tree: a property or an element
+ * of an array, and descends with operator[] or range-for over
+ * members and elements. Values are read with type checked as<T>()
+ * and try_get<T>(), which switch on Kind instead of virtual calls
+ * and dynamic_cast. Nothing is allocated while moving around.
+ * Missing members and elements give a cursor which is false */
+
+struct Cursor{
+
+    Cursor()=default;
+
+    Cursor(const prop* node):m_node(node){}
+
+    Cursor(const prop& node):m_node(&node){}
+
+    Cursor(const JSON& doc):m_node(&doc.root()){}
+
+    explicit operator bool() const {
+        return m_node!=nullptr;
+    }
+
+    JType type() const {
+        if (!m_node)
+            return JType::Null;
+
+        switch (m_node->m_kind) {
+        case Kind::I32:
+        case Kind::I64:
+        case Kind::D:
+        case Kind::LD:
+            return JType::Number;
+        case Kind::String:
+            return JType::String;
+        case Kind::Bool:
+            return JType::Bool;
+        case Kind::Null:
+            return JType::Null;
+        case Kind::Object:
+            return JType::Object;
+        case Kind::ArrI32:
+        case Kind::ArrI64:
+        case Kind::ArrD:
+        case Kind::ArrLD:
+            return m_elem?JType::Number:JType::Array;
+        case Kind::ArrString:
+            return m_elem?JType::String:JType::Array;
+        case Kind::ArrBool:
+            return m_elem?JType::Bool:JType::Array;
+        case Kind::ArrNull:
+            return m_elem?JType::Null:JType::Array;
+        case Kind::ArrObject:
+        case Kind::ArrAny:
+            return JType::Array;
+        default:
+            return m_node->Type();
+        }
+    }
+
+    bool isNull() const {
+        return type()==JType::Null;
+    }
+
+    /* key of object member, empty for array elements */
+    std::string_view name() const {
+        if (!m_node||m_elem)
+            return std::string_view();
+
+        return m_node->m_name;
+    }
+
+    /* number of members or elements */
+    size_t size() const {
+        if (!m_node||m_elem)
+            return 0;
+
+        switch (m_node->m_kind) {
+        case Kind::Object:    return static_cast<const Obj*>(m_node)->props.size();
+        case Kind::ArrI32:    return arr<int32_t>().size();
+        case Kind::ArrI64:    return arr<int64_t>().size();
+        case Kind::ArrD:      return arr<double>().size();
+        case Kind::ArrLD:     return arr<long double>().size();
+        case Kind::ArrString: return arr<string>().size();
+        case Kind::ArrBool:   return arr<bool>().size();
+        case Kind::ArrNull:   return arr<Null_val>().size();
+        case Kind::ArrObject: return arr<Obj*>().size();
+        case Kind::ArrAny:    return arr<prop*>().size();
+        default:              return 0;
+        }
+    }
+
+    /* object member */
+    Cursor operator[](std::string_view key) const {
+        if (!m_node||m_elem||m_node->m_kind!=Kind::Object)
+            return Cursor();
+
+        for (auto x: static_cast<const Obj*>(m_node)->props)
+            if (x->m_name==key)
+                return Cursor(x);
+
+        return Cursor();
+    }
+
+    /* i-th object member or array element */
+    Cursor operator[](size_t i) const {
+        if (i>=size())
+            return Cursor();
+
+        switch (m_node->m_kind) {
+        case Kind::Object:    return Cursor(static_cast<const Obj*>(m_node)->props[i]);
+        case Kind::ArrObject: return Cursor(arr<Obj*>()[i]);
+        case Kind::ArrAny:    return Cursor(arr<prop*>()[i]);
+        default:              return Cursor(m_node, i);
+        }
+    }
+
+    /* stores value in res if it has type T, supported are
+     * int32_t, int64_t, double, long double, bool,
+     * std::string_view and std::string */
+    template <typename T>
+    bool try_get(T& res) const {
+        return get(res);
+    }
+
+    /* value of type T, throws std::logic_error for other types */
+    template <typename T>
+    T as() const {
+        T res;
+
+        if (!get(res))
+            throw std::logic_error("value of "+string(name())+" has other type");
+
+        return res;
+    }
+
+    struct iterator{
+
+        iterator(const prop* parent, size_t i):m_parent(parent),m_i(i){}
+
+        Cursor operator*() const {
+            return Cursor(m_parent)[m_i];
+        }
+
+        iterator& operator++(){
+            ++m_i;
+            return *this;
+        }
+
+        bool operator==(const iterator& op2) const {
+            return m_i==op2.m_i;
+        }
+
+        bool operator!=(const iterator& op2) const {
+            return m_i!=op2.m_i;
+        }
+
+    private:
+        const prop* m_parent;
+        size_t m_i;
+    };
+
+    iterator begin() const {
+        return iterator(m_elem?nullptr:m_node, 0);
+    }
+
+    iterator end() const {
+        return iterator(m_elem?nullptr:m_node, size());
+    }
+
+private:
+
+    /* element i of array node */
+    Cursor(const prop* node, size_t i):m_node(node),m_idx(i),m_elem(true){}
+
+    template <typename T>
+    const std::vector<T>& arr() const {
+        return static_cast<const Arr<T>*>(m_node)->value;
+    }
+
+    template <typename T>
+    const T& num() const {
+        return static_cast<const Num<T>*>(m_node)->value;
+    }
+
+    /* calls f with the number pointed to */
+    template <typename F>
+    bool number(F f) const {
+        if (!m_node)
+            return false;
+
+        if (m_elem){
+            switch (m_node->m_kind) {
+            case Kind::ArrI32: return f(arr<int32_t>()[m_idx]);
+            case Kind::ArrI64: return f(arr<int64_t>()[m_idx]);
+            case Kind::ArrD:   return f(arr<double>()[m_idx]);
+            case Kind::ArrLD:  return f(arr<long double>()[m_idx]);
+            default:           return false;
+            }
+        }
+
+        switch (m_node->m_kind) {
+        case Kind::I32: return f(num<int32_t>());
+        case Kind::I64: return f(num<int64_t>());
+        case Kind::D:   return f(num<double>());
+        case Kind::LD:  return f(num<long double>());
+        default:        return false;
+        }
+    }
+
+    bool get(int64_t& res) const {
+        return number([&res](auto v){
+            if (!std::is_integral<decltype(v)>::value)
+                return false;
+
+            res=v;
+            return true;
+        });
+    }
+
+    bool get(int32_t& res) const {
+        int64_t v;
+
+        if (!get(v)||v<std::numeric_limits<int32_t>::min()||v>std::numeric_limits<int32_t>::max())
+            return false;
+
+        res=v;
+        return true;
+    }
+
+    bool get(double& res) const {
+        return number([&res](auto v){
+            res=v;
+            return true;
+        });
+    }
+
+    bool get(long double& res) const {
+        return number([&res](auto v){
+            res=v;
+            return true;
+        });
+    }
+
+    bool get(bool& res) const {
+        if (!m_node)
+            return false;
+
+        if (m_elem&&m_node->m_kind==Kind::ArrBool)
+            res=arr<bool>()[m_idx];
+        else if (!m_elem&&m_node->m_kind==Kind::Bool)
+            res=static_cast<const Boo*>(m_node)->value;
+        else return false;
+
+        return true;
+    }
+
+    bool get(std::string_view& res) const {
+        if (!m_node)
+            return false;
+
+        if (m_elem&&m_node->m_kind==Kind::ArrString)
+            res=arr<string>()[m_idx];
+        else if (!m_elem&&m_node->m_kind==Kind::String)
+            res=static_cast<const Str*>(m_node)->value;
+        else return false;
+
+        return true;
+    }
+
+    bool get(string& res) const {
+        std::string_view v;
+
+        if (!get(v))
+            return false;
+
+        res.assign(v.data(), v.size());
+        return true;
+    }
+
+    const prop* m_node{nullptr};
+    size_t m_idx{0};
+    bool m_elem{false};
+};
+
+/* Immutable document. Its tree is never changed after
+ * construction, so one Frozen can be read from many threads.
+ * It is read only through Cursor, which can't change nodes */
+
+struct Frozen{
+
+    Frozen(const std::string& input){
+        m_obj.Parse(input);
+    }
+
+    /* takes over the tree of obj */
+    Frozen(Obj&& obj):m_obj(std::move(obj)){
+        /* members still point to obj as their container, and
+         * fragments are not kept as toStr() would change them
+         * from many threads */
+        m_obj.detach();
+    }
+
+    Frozen(const Frozen&)=delete;
+    Frozen& operator=(const Frozen&)=delete;
+
+    ~Frozen(){
+        m_obj.memfree();
+    }
+
+    Cursor root() const {
+        return Cursor(m_obj);
+    }
+
+    Cursor operator[](std::string_view name) const {
+        return root()[name];
+    }
+
+    size_t size() const {
+        return m_obj.size();
+    }
+
+    std::string toStr() const {
+        return m_obj.toStr();
+    }
+
+    Cursor::iterator begin() const {
+        return root().begin();
+    }
+
+    Cursor::iterator end() const {
+        return root().end();
+    }
+
+private:
+    friend struct Shared;
+
+    Obj m_obj;
+};
+
+typedef std::shared_ptr<const Frozen> Snapshot;
+
+/* Shared keeps the current version of a document. Writers make a
+ * copy, change it and publish it as the next version; versions in
+ * use by readers live until the last Snapshot of them is gone */
+
+struct Shared{
+
+    Shared(Snapshot doc):m_cur(doc){}
+
+    /* reference counted current version. atomic_load of shared_ptr
+     * takes a lock from a small pool in libstdc++, it isn't lock free,
+     * so frequent readers should go through Reader */
+    Snapshot get() const {
+        return std::atomic_load(&m_cur);
+    }
+
+    /* copy on write: edit gets a deep copy of the current version
+     * which is then published atomically, writers are serialized */
+    void update(const std::function<void(Obj&)>& edit){
+        std::lock_guard<std::mutex> lock(m_write);
+
+        Obj* copy=(Obj*)get()->m_obj.clone();
+
+        try {
+            edit(*copy);
+        } catch (...) {
+            copy->memfree();
+            delete copy;
+            throw;
+        }
+
+        Snapshot next=std::make_shared<const Frozen>(std::move(*copy));
+        delete copy;
+
+        publish(next);
+    }
+
+    void publish(Snapshot doc){
+        std::atomic_store(&m_cur, doc);
+        m_version.fetch_add(1, std::memory_order_release);
+    }
+
+    uint64_t version() const {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+private:
+    Snapshot m_cur;
+    std::atomic<uint64_t> m_version{0};
+    std::mutex m_write;
+};
+
+/* Reader is a per thread view of Shared. It keeps its own Snapshot
+ * and reloads it only when the version changes. A read of an
+ * unchanged version is one atomic load of the version counter, it
+ * doesn't lock or touch shared reference counts; a reload goes
+ * through Shared::get and locks. A publish between loading the
+ * version and the Snapshot costs one more reload */
+
+struct Reader{
+
+    Reader(const Shared& doc):m_doc(doc){}
+
+    const Frozen& get(){
+        uint64_t v=m_doc.version();
+
+        if (!m_snap||v!=m_seen){
+            m_snap=m_doc.get();
+            m_seen=v;
+        }
+
+        return *m_snap;
+    }
+
+    const Frozen* operator->(){
+        return &get();
+    }
+
+private:
+    const Shared& m_doc;
+    Snapshot m_snap;
+    uint64_t m_seen{0};
+};
+
+/* Result of validate and Scanner::run */
+
+struct Status{
+
+    bool ok{true};
+
+    /* position of the error, line and column start from 1 */
+    size_t offset{0};
+    size_t line{1};
+    size_t column{1};
+
+    const char* reason{""};
+
+    explicit operator bool() const { return ok; }
+};
+
+/* Scanner tokenizes RFC 8259 JSON text calling handler H for
+ * every token, strings are passed without quotes and escapes
+ * are left as is. Nothing is allocated but the stack of open
+ * brackets. H has to provide:
+ *   begin_obj() end_obj() begin_arr() end_arr()
+ *   key(const char*, size_t) str(const char*, size_t)
+ *   num(const char*, size_t) lit(const char*, size_t) */
+
+template <typename H>
+struct Scanner{
+
+    /* with sequence set input may hold several values
+     * separated by whitespace, like NDJSON */
+    Scanner(const char* data, size_t size, H& handler, size_t max_depth=512, bool sequence=false)
+        :m_data(data),m_size(size),m_h(handler),m_max_depth(max_depth),m_sequence(sequence){}
+
+    Status run(){
+
+        enum { Value, Key, Next } state=Value;
+
+        std::string stack;
+
+        size_t p=ws(0);
+
+        for (;;){
+
+            if (state==Value){
+
+                if (p>=m_size)
+                    return fail(p, "unexpected end of input");
+
+                switch (m_data[p]) {
+                case '{':
+                case '[':
+
+                    if (stack.size()>=m_max_depth)
+                        return fail(p, "maximum depth exceeded");
+
+                    stack.push_back(m_data[p]);
+
+                    if (m_data[p]=='{'){
+                        m_h.begin_obj();
+                        p=ws(p+1);
+
+                        if (p<m_size&&m_data[p]=='}'){
+                            stack.pop_back();
+                            m_h.end_obj();
+                            p=ws(p+1);
+                            state=Next;
+                        } else state=Key;
+
+                    } else {
+                        m_h.begin_arr();
+                        p=ws(p+1);
+
+                        if (p<m_size&&m_data[p]==']'){
+                            stack.pop_back();
+                            m_h.end_arr();
+                            p=ws(p+1);
+                            state=Next;
+                        }
+                    }
+
+                    continue;
+
+                case '"':{
+                    size_t e=string_end(p);
+
+                    if (e==0)
+                        return m_err;
+
+                    m_h.str(m_data+p+1, e-p-2);
+                    p=e;
+                    break;
+                }
+
+                case 't':
+                    if (!literal(p, "true", 4))
+                        return fail(p, "invalid literal");
+                    m_h.lit(m_data+p, 4);
+                    p+=4;
+                    break;
+
+                case 'f':
+                    if (!literal(p, "false", 5))
+                        return fail(p, "invalid literal");
+                    m_h.lit(m_data+p, 5);
+                    p+=5;
+                    break;
+
+                case 'n':
+                    if (!literal(p, "null", 4))
+                        return fail(p, "invalid literal");
+                    m_h.lit(m_data+p, 4);
+                    p+=4;
+                    break;
+
+                default:{
+                    size_t e=number_end(p);
+
+                    if (e==0)
+                        return m_err;
+
+                    m_h.num(m_data+p, e-p);
+                    p=e;
+                }
+                }
+
+                p=ws(p);
+                state=Next;
+
+            } else if (state==Key){
+
+                if (p>=m_size||m_data[p]!='"')
+                    return fail(p, "expected string key");
+
+                size_t e=string_end(p);
+
+                if (e==0)
+                    return m_err;
+
+                m_h.key(m_data+p+1, e-p-2);
+
+                p=ws(e);
+
+                if (p>=m_size||m_data[p]!=':')
+                    return fail(p, "expected ':'");
+
+                p=ws(p+1);
+                state=Value;
+
+            } else {
+
+                if (stack.empty()){
+                    if (p!=m_size&&m_sequence){
+                        state=Value;
+                        continue;
+                    }
+
+                    if (p!=m_size)
+                        return fail(p, "unexpected data after value");
+
+                    return Status();
+                }
+
+                if (p>=m_size)
+                    return fail(p, "unexpected end of input");
+
+                char c=m_data[p];
+
+                if (c==','){
+                    p=ws(p+1);
+                    state=(stack.back()=='{')?Key:Value;
+                } else if (c=='}'&&stack.back()=='{'){
+                    stack.pop_back();
+                    m_h.end_obj();
+                    p=ws(p+1);
+                } else if (c==']'&&stack.back()=='['){
+                    stack.pop_back();
+                    m_h.end_arr();
+                    p=ws(p+1);
+                } else return fail(p, stack.back()=='{'?"expected ',' or '}'":"expected ',' or ']'");
+            }
+        }
+    }
+
+private:
+
+    size_t ws(size_t p) const {
+        /* most tokens are followed by a structural character or one space */
+        if (p<m_size&&(unsigned char)m_data[p]>' ')
+            return p;
+
+        while (p<m_size&&(m_data[p]==' '||m_data[p]=='\n'||m_data[p]=='\r'||m_data[p]=='\t'))
+            ++p;
+
+        return p;
+    }
+
+    bool literal(size_t p, const char* lit, size_t len) const {
+        return m_size-p>=len&&memcmp(m_data+p, lit, len)==0;
+    }
+
+    static bool hex(char c){
+        return ::isxdigit((unsigned char)c);
+    }
+
+    /* returns position after closing quote of string at p, 0 on error */
+    size_t string_end(size_t p){
+
+        const unsigned char* d=(const unsigned char*)m_data;
+
+        ++p;
+
+        for (;;){
+
+            /* skip 8 plain ascii characters at once */
+            while (m_size-p>=8){
+                uint64_t x;
+                memcpy(&x, d+p, 8);
+
+                const uint64_t ones=0x0101010101010101ULL;
+                const uint64_t high=0x8080808080808080ULL;
+
+                uint64_t quote=x^(ones*'"');
+                uint64_t slash=x^(ones*'\\');
+
+                uint64_t special=((quote-ones)&~quote)|((slash-ones)&~slash)|((x-ones*0x20)&~x)|x;
+
+                if (special&high)
+                    break;
+
+                p+=8;
+            }
+
+            if (p>=m_size){
+                fail(p, "unterminated string");
+                return 0;
+            }
+
+            unsigned char c=d[p];
+
+            if (c=='"')
+                return p+1;
+
+            if (c<0x20){
+                fail(p, "control character in string");
+                return 0;
+            }
+
+            if (c=='\\'){
+
+                if (p+1>=m_size){
+                    fail(p, "unterminated string");
+                    return 0;
+                }
+
+                switch (d[p+1]) {
+                case '"': case '\\': case '/': case 'b':
+                case 'f': case 'n': case 'r': case 't':
+                    p+=2;
+                    break;
+                case 'u':
+                    if (m_size-p<6||!hex(d[p+2])||!hex(d[p+3])||!hex(d[p+4])||!hex(d[p+5])){
+                        fail(p, "invalid unicode escape");
+                        return 0;
+                    }
+                    p+=6;
+                    break;
+                default:
+                    fail(p, "invalid escape");
+                    return 0;
+                }
+
+            } else if (c<0x80){
+                /* rest of the plain characters SWAR stopped in */
+                do
+                    ++p;
+                while (p<m_size&&d[p]>=0x20&&d[p]<0x80&&d[p]!='"'&&d[p]!='\\');
+            } else {
+                size_t len=utf8_len(d+p, m_size-p);
+
+                if (len==0){
+                    fail(p, "invalid UTF-8");
+                    return 0;
+                }
+
+                p+=len;
+            }
+        }
+    }
+
+    /* length of well formed UTF-8 sequence, 0 if it isn't */
+    static size_t utf8_len(const unsigned char* s, size_t left){
+
+        size_t len;
+        unsigned char lo=0x80, hi=0xBF;
+
+        if (s[0]>=0xC2&&s[0]<=0xDF)
+            len=2;
+        else if (s[0]>=0xE0&&s[0]<=0xEF){
+            len=3;
+            if (s[0]==0xE0) lo=0xA0;
+            if (s[0]==0xED) hi=0x9F;
+        } else if (s[0]>=0xF0&&s[0]<=0xF4){
+            len=4;
+            if (s[0]==0xF0) lo=0x90;
+            if (s[0]==0xF4) hi=0x8F;
+        } else return 0;
+
+        if (left<len||s[1]<lo||s[1]>hi)
+            return 0;
+
+        for (size_t i=2;i<len;++i)
+            if (s[i]<0x80||s[i]>0xBF)
+                return 0;
+
+        return len;
+    }
+
+    /* returns position after number at p, 0 on error */
+    size_t number_end(size_t p){
+
+        const char* d=m_data;
+        size_t b=p;
+
+        /* runs of digits are skipped without a bounds check per character */
+        auto digits=[d, this](size_t i){
+            while (i<m_size&&(unsigned)(d[i]-'0')<10)
+                ++i;
+            return i;
+        };
+
+        if (d[p]=='-')
+            ++p;
+
+        size_t e=digits(p);
+
+        if (e==p){
+            fail(b, p==b?"unexpected character":"invalid number");
+            return 0;
+        }
+
+        /* leading zero ends the integer part */
+        p=(d[p]=='0')?p+1:e;
+
+        if (p<m_size&&d[p]=='.'){
+            e=digits(++p);
+
+            if (e==p){
+                fail(p, "invalid number");
+                return 0;
+            }
+
+            p=e;
+        }
+
+        if (p<m_size&&(d[p]|0x20)=='e'){
+            ++p;
+
+            if (p<m_size&&(d[p]=='+'||d[p]=='-'))
+                ++p;
+
+            e=digits(p);
+
+            if (e==p){
+                fail(p, "invalid number");
+                return 0;
+            }
+
+            p=e;
+        }
+
+        return p;
+    }
+
+    Status fail(size_t p, const char* reason){
+        m_err.ok=false;
+        m_err.offset=p;
+        m_err.reason=reason;
+        m_err.line=1+std::count(m_data, m_data+p, '\n');
+
+        size_t nl=p;
+
+        while (nl>0&&m_data[nl-1]!='\n')
+            --nl;
+
+        m_err.column=p-nl+1;
+
+        return m_err;
+    }
+
+    const char* m_data;
+    size_t m_size;
+    H& m_h;
+    size_t m_max_depth;
+    bool m_sequence;
+    Status m_err;
+};
+
+namespace Hlp {
+
+/* Scanner handler doing nothing */
+struct Skip{
+    void begin_obj(){}
+    void end_obj(){}
+    void begin_arr(){}
+    void end_arr(){}
+    void key(const char*, size_t){}
+    void str(const char*, size_t){}
+    void num(const char*, size_t){}
+    void lit(const char*, size_t){}
+};
+
+} //Hlp namespace
+
+/* checks that data is valid JSON text without building anything */
+Status validate(const char* data, size_t size, size_t max_depth=512){
+    Hlp::Skip skip;
+
+    return Scanner<Hlp::Skip>(data, size, skip, max_depth).run();
+}
+
+/* Writer is a Scanner handler writing tokens back as JSON text,
+ * minified or pretty printed, into out. Each top level value ends
+ * with a newline. In lines mode elements of a top level array are
+ * written as separate values, which gives NDJSON */
+
+struct Writer{
+
+    /* indent<0 writes minified text */
+    Writer(std::string& out, int indent=-1, bool lines=false)
+        :m_out(out),m_indent(indent),m_lines(lines){}
+
+    void begin_obj(){
+        before();
+
+        m_out+='{';
+        m_first=true;
+        ++m_depth;
+    }
+
+    void end_obj(){
+        close('}');
+    }
+
+    void begin_arr(){
+        if (m_lines&&!m_unwrap&&!m_key&&m_depth==0){
+            m_unwrap=true;
+            return;
+        }
+
+        before();
+
+        m_out+='[';
+        m_first=true;
+        ++m_depth;
+    }
+
+    void end_arr(){
+        if (m_unwrap&&m_depth==0){
+            m_unwrap=false;
+            return;
+        }
+
+        close(']');
+    }
+
+    void key(const char* str, size_t len){
+        next();
+
+        m_out+='"';
+        m_out.append(str, len);
+        m_out+=(m_indent<0)?"\":":"\": ";
+
+        m_key=true;
+    }
+
+    void str(const char* str, size_t len){
+        before();
+
+        m_out+='"';
+        m_out.append(str, len);
+        m_out+='"';
+
+        done();
+    }
+
+    void num(const char* str, size_t len){
+        before();
+
+        m_out.append(str, len);
+
+        done();
+    }
+
+    void lit(const char* str, size_t len){
+        num(str, len);
+    }
+
+private:
+
+    void before(){
+        if (m_key)
+            m_key=false;
+        else if (m_depth>0)
+            next();
+    }
+
+    /* separator and indent before a member or element */
+    void next(){
+        if (!m_first)
+            m_out+=',';
+
+        m_first=false;
+
+        newline(m_depth);
+    }
+
+    void newline(size_t depth){
+        if (m_indent<0)
+            return;
+
+        m_out+='\n';
+        m_out.append(depth*m_indent, ' ');
+    }
+
+    void close(char c){
+        --m_depth;
+
+        if (!m_first)
+            newline(m_depth);
+
+        m_out+=c;
+        m_first=false;
+
+        done();
+    }
+
+    /* ends top level value */
+    void done(){
+        if (m_depth==0)
+            m_out+='\n';
+    }
+
+    std::string& m_out;
+    int m_indent;
+    bool m_lines;
+
+    size_t m_depth{0};
+
+    /* nothing written yet in current container */
+    bool m_first{true};
+
+    /* key was written, value follows */
+    bool m_key{false};
+
+    /* inside top level array in lines mode */
+    bool m_unwrap{false};
+};
+
+namespace Hlp {
+
+/* appends JSON string body str[0..len) to res with escapes decoded */
+void unescape(const char* str, size_t len, string& res){
+
+    auto hex4=[](const char* h){
+        return (unsigned)std::stoul(string(h, 4), nullptr, 16);
+    };
+
+    for (size_t i=0;i<len;++i){
+
+        const char* esc=(const char*)memchr(str+i, '\\', len-i);
+
+        if (!esc){
+            res.append(str+i, len-i);
+            return;
+        }
+
+        res.append(str+i, esc-str-i);
+        i=esc-str;
+
+        char c=str[++i];
+
+        switch (c) {
+        case 'b': res+='\b'; break;
+        case 'f': res+='\f'; break;
+        case 'n': res+='\n'; break;
+        case 'r': res+='\r'; break;
+        case 't': res+='\t'; break;
+        case 'u':{
+            unsigned cp=hex4(str+i+1);
+            i+=4;
+
+            /* surrogate pair */
+            if (cp>=0xD800&&cp<0xDC00&&i+6<len&&str[i+1]=='\\'&&str[i+2]=='u'){
+                unsigned lo=hex4(str+i+3);
+
+                if (lo>=0xDC00&&lo<0xE000){
+                    cp=0x10000+((cp-0xD800)<<10)+(lo-0xDC00);
+                    i+=6;
+                }
+            }
+
+            if (cp<0x80)
+                res+=(char)cp;
+            else if (cp<0x800){
+                res+=(char)(0xC0|(cp>>6));
+                res+=(char)(0x80|(cp&0x3F));
+            } else if (cp<0x10000){
+                res+=(char)(0xE0|(cp>>12));
+                res+=(char)(0x80|((cp>>6)&0x3F));
+                res+=(char)(0x80|(cp&0x3F));
+            } else {
+                res+=(char)(0xF0|(cp>>18));
+                res+=(char)(0x80|((cp>>12)&0x3F));
+                res+=(char)(0x80|((cp>>6)&0x3F));
+                res+=(char)(0x80|(cp&0x3F));
+            }
+            break;
+        }
+        default: res+=c;
+        }
+    }
+}
+
+} //Hlp namespace
+
+/* Column of values of one key across records. Numbers and bools
+ * are kept in ints or reals, strings in data with offsets[i] and
+ * offsets[i+1] bounding value of row i. Bit i of valid is cleared
+ * when row i is null or its value doesn't fit the column type */
+
+struct Column{
+
+    Column(const string& name):name(name){}
+
+    /* type of the first non null value, Null while there is none */
+    JType type{JType::Null};
+
+    /* widest number type seen, integers are stored in ints
+     * until a real number appears */
+    NType ntype{NType::i32};
+
+    bool isNull(size_t row) const {
+        return !(valid[row>>3]&(1<<(row&7)));
+    }
+
+    size_t size() const {
+        return rows;
+    }
+
+    string name;
+    size_t rows{0};
+
+    std::vector<int64_t> ints;
+    std::vector<double> reals;
+    std::vector<size_t> offsets;
+    string data;
+    std::vector<uint8_t> valid;
+
+    void push_null(){
+        push(false);
+    }
+
+    void push_bool(bool val){
+        if (!settle(JType::Bool))
+            return push_null();
+
+        ints.push_back(val);
+        push(true);
+    }
+
+    void push_str(const char* str, size_t len){
+        if (!settle(JType::String))
+            return push_null();
+
+        Hlp::unescape(str, len, data);
+        offsets.push_back(data.size());
+        push(true);
+    }
+
+    /* num is a number token validated by Scanner, integers past
+     * int64 are kept as reals, values past double range are null */
+    void push_num(const char* num, size_t len){
+        if (!settle(JType::Number))
+            return push_null();
+
+        bool real=std::find_first_of(num, num+len, "eE.", "eE."+3)!=num+len;
+
+        if (!real){
+
+            int64_t val;
+
+            try {
+                val=Hlp::parse_int(num, num+len);
+            } catch (const std::out_of_range&) {
+                return push_real(num, len);
+            }
+
+            NType nt=(val<INT32_MIN||val>INT32_MAX)?NType::i64:NType::i32;
+
+            if (nt>ntype)
+                ntype=nt;
+
+            if (ntype<NType::d)
+                ints.push_back(val);
+            else reals.push_back(val);
+
+            push(true);
+
+        } else push_real(num, len);
+    }
+
+private:
+
+    void push_real(const char* num, size_t len){
+
+        char buff[64];
+        string big;
+        const char* z=num;
+
+        /* token is not terminated */
+        if (len<sizeof(buff)){
+            memcpy(buff, num, len);
+            buff[len]=0;
+            z=buff;
+        } else {
+            big.assign(num, len);
+            z=big.c_str();
+        }
+
+        double val=std::strtod(z, nullptr);
+
+        /* inf can't be written back as JSON or CSV number */
+        if (!std::isfinite(val))
+            return push(false);
+
+        if (ntype<NType::d){
+            reals.assign(ints.begin(), ints.end());
+            ints.clear();
+            ntype=NType::d;
+        }
+
+        reals.push_back(val);
+        push(true);
+    }
+
+    /* fixes column type on the first non null value,
+     * returns false if t doesn't match it */
+    bool settle(JType t){
+        if (type==t)
+            return true;
+
+        if (type!=JType::Null)
+            return false;
+
+        type=t;
+
+        /* storage for rows which were null so far */
+        if (t==JType::String)
+            offsets.assign(rows+1, 0);
+        else ints.assign(rows, 0);
+
+        return true;
+    }
+
+    void push(bool ok){
+
+        if (!ok&&type!=JType::Null){
+            if (type==JType::String)
+                offsets.push_back(data.size());
+            else if (ntype<NType::d||type==JType::Bool)
+                ints.push_back(0);
+            else reals.push_back(0);
+        }
+
+        if ((rows&7)==0)
+            valid.push_back(0);
+
+        if (ok)
+            valid.back()|=1<<(rows&7);
+
+        ++rows;
+    }
+};
+
+/* Columns of an array of records */
+
+struct Columns{
+
+    Column* find(const string& name){
+        for (auto& x: cols)
+            if (x.name==name)
+                return &x;
+
+        return nullptr;
+    }
+
+    /* writes columns as CSV with header line, nulls are empty */
+    void toCSV(std::ostream& out) const {
+
+        for (size_t i=0;i<cols.size();++i)
+            out << (i?",":"") << quote(cols[i].name);
+
+        out << "\n";
+
+        char buff[64];
+
+        for (size_t r=0;r<rows;++r){
+
+            for (size_t i=0;i<cols.size();++i){
+
+                const Column& c=cols[i];
+
+                if (i)
+                    out << ',';
+
+                if (c.isNull(r))
+                    continue;
+
+                if (c.type==JType::String)
+                    out << quote(c.data.substr(c.offsets[r], c.offsets[r+1]-c.offsets[r]));
+                else if (c.type==JType::Bool)
+                    out << (c.ints[r]?"true":"false");
+                else if (c.ntype<NType::d)
+                    out << c.ints[r];
+                else {
+                    auto res=std::to_chars(buff, buff+sizeof(buff), c.reals[r]);
+                    out.write(buff, res.ptr-buff);
+                }
+            }
+
+            out << "\n";
+        }
+    }
+
+    std::vector<Column> cols;
+    size_t rows{0};
+
+private:
+
+    static string quote(const string& str){
+        if (str.find_first_of(",\"\r\n")==string::npos)
+            return str;
+
+        string res="\"";
+
+        for (auto c: str){
+            if (c=='"')
+                res+='"';
+            res+=c;
+        }
+
+        return res+"\"";
+    }
+};
+
+namespace Hlp {
+
+/* Scanner handler filling Columns, keys of nested objects are
+ * joined with '.', arrays inside records give null */
+struct ColumnBuilder{
+
+    ColumnBuilder(Columns& res):res(res){}
+
+    void begin_obj(){
+        if (skip){
+            ++skip;
+            return;
+        }
+
+        if (depth==rec_depth){
+            path.clear();
+            hint=0;
+        } else if (depth>rec_depth)
+            path.push_back(name_len);
+
+        ++depth;
+    }
+
+    void end_obj(){
+        if (skip){
+            --skip;
+            return;
+        }
+
+        --depth;
+
+        if (depth==rec_depth)
+            end_record();
+        else if (depth>rec_depth){
+            name.resize(path.back());
+            path.pop_back();
+        }
+    }
+
+    void begin_arr(){
+        if (skip){
+            ++skip;
+            return;
+        }
+
+        /* top level array holds records */
+        if (depth==0){
+            rec_depth=1;
+            ++depth;
+            return;
+        }
+
+        if (depth>rec_depth)
+            value()->push_null();
+
+        ++skip;
+    }
+
+    void end_arr(){
+        if (skip){
+            --skip;
+            return;
+        }
+
+        /* records of next top level value start at its level */
+        if (--depth==0)
+            rec_depth=0;
+    }
+
+    void key(const char* str, size_t len){
+        if (skip)
+            return;
+
+        name.resize(path.empty()?0:path.back());
+
+        if (!path.empty())
+            name+='.';
+
+        name.append(str, len);
+        name_len=name.size();
+    }
+
+    void str(const char* str, size_t len){
+        if (!skip&&depth>rec_depth)
+            value()->push_str(str, len);
+    }
+
+    void num(const char* str, size_t len){
+        if (!skip&&depth>rec_depth)
+            value()->push_num(str, len);
+    }
+
+    void lit(const char* str, size_t){
+        if (skip||depth<=rec_depth)
+            return;
+
+        if (str[0]=='n')
+            value()->push_null();
+        else value()->push_bool(str[0]=='t');
+    }
+
+private:
+
+    /* column for current key, or a dummy one if key
+     * is repeated in the record */
+    Column* value(){
+
+        Column* c=nullptr;
+
+        if (hint<res.cols.size()&&res.cols[hint].name==name)
+            c=&res.cols[hint];
+        else c=res.find(name);
+
+        if (!c){
+            res.cols.push_back(Column(name));
+            c=&res.cols.back();
+        }
+
+        hint=c-res.cols.data()+1;
+
+        while (c->rows<res.rows)
+            c->push_null();
+
+        if (c->rows>res.rows){
+            dummy.rows=0;
+            return &dummy;
+        }
+
+        return c;
+    }
+
+    void end_record(){
+        ++res.rows;
+
+        for (auto& x: res.cols)
+            while (x.rows<res.rows)
+                x.push_null();
+    }
+
+    Columns& res;
+    Column dummy{""};
+
+    /* depth of open containers and depth where records start */
+    size_t depth{0};
+    size_t rec_depth{0};
+
+    /* nesting level of skipped array */
+    size_t skip{0};
+
+    /* full name of current key and its length at each open object */
+    string name;
+    size_t name_len{0};
+    std::vector<size_t> path;
+
+    /* index of column expected next */
+    size_t hint{0};
+};
+
+} //Hlp namespace
+
+/* Builds columns from array of objects or from NDJSON without
+ * building tree, types are widened as in Obj::parse_arr.
+ * Throws std::logic_error on invalid input */
+Columns parse_columns(const char* data, size_t size){
+    Columns res;
+    Hlp::ColumnBuilder b(res);
+
+    Status st=Scanner<Hlp::ColumnBuilder>(data, size, b, 512, true).run();
+
+    if (!st)
+        throw std::logic_error(string(st.reason)+" "+std::to_string(st.offset));
+
+    return res;
+}
+
+Columns parse_columns(const string& input){
+    return parse_columns(input.data(), input.size());
+}
+
+
+/* Patching works on text: targets are found by walking members
+ * and elements with Hlp::skip_value and the result is made of
+ * unchanged regions of the document around spliced values.
+ * Document is expected to be valid JSON, see validate() */
+
+namespace Hlp {
+
+/* calls f(key_begin, key_end, value_begin, value_end) for members of
+ * object at from, key is without quotes. Stops when f returns false,
+ * returns position of closing '}' or of member where it stopped */
+template <typename F>
+size_t each_member(const string& str, size_t from, F f){
+
+    size_t p=skip_ws(str, from+1);
+
+    while (str[p]=='"'){
+
+        size_t ke=skip_value(str, p);
+        size_t vb=skip_ws(str, skip_ws(str, ke)+1);
+        size_t ve=skip_value(str, vb);
+
+        if (!f(p+1, ke-1, vb, ve))
+            return p;
+
+        p=skip_ws(str, ve);
+
+        if (str[p]==',')
+            p=skip_ws(str, p+1);
+    }
+
+    if (str[p]!='}')
+        throw std::logic_error("'}' expected "+std::to_string(p));
+
+    return p;
+}
+
+/* calls f(value_begin, value_end) for elements of array at from,
+ * same as each_member */
+template <typename F>
+size_t each_elem(const string& str, size_t from, F f){
+
+    size_t p=skip_ws(str, from+1);
+
+    while (p<str.size()&&str[p]!=']'){
+
+        size_t e=skip_value(str, p);
+
+        if (!f(p, e))
+            return p;
+
+        p=skip_ws(str, e);
+
+        if (str[p]==',')
+            p=skip_ws(str, p+1);
+    }
+
+    if (p>=str.size())
+        throw std::logic_error("']' expected "+std::to_string(p));
+
+    return p;
+}
+
+/* text of JSON string at str[b, e), escapes decoded */
+string str_value(const string& str, size_t b, size_t e){
+    string res;
+    unescape(str.c_str()+b, e-b, res);
+    return res;
+}
+
+/* compares raw key with decoded name */
+bool same_key(const string& str, size_t b, size_t e, const string& name){
+    if (memchr(str.c_str()+b, '\\', e-b))
+        return str_value(str, b, e)==name;
+
+    return e-b==name.size()&&str.compare(b, e-b, name)==0;
+}
+
+/* minified copy of value str[b, e) */
+string minify(const string& str, size_t b, size_t e){
+    string res;
+    Writer w(res);
+
+    Status st=Scanner<Writer>(str.c_str()+b, e-b, w).run();
+
+    if (!st)
+        throw std::logic_error(string(st.reason)+" "+std::to_string(b+st.offset));
+
+    res.pop_back();
+
+    return res;
+}
+
+/* splits JSON Pointer (RFC 6901) into decoded tokens */
+std::vector<string> pointer(const string& path){
+    std::vector<string> res;
+
+    if (path.empty())
+        return res;
+
+    if (path[0]!='/')
+        throw std::logic_error("invalid pointer "+path);
+
+    for (size_t l=1, r;l<=path.size();l=r+1){
+
+        r=path.find('/', l);
+
+        if (r==string::npos)
+            r=path.size();
+
+        string tok;
+
+        for (size_t i=l;i<r;++i){
+            if (path[i]=='~'&&i+1<r&&(path[i+1]=='0'||path[i+1]=='1'))
+                tok+=(path[++i]=='0')?'~':'/';
+            else tok+=path[i];
+        }
+
+        res.push_back(tok);
+    }
+
+    return res;
+}
+
+/* array index from pointer token */
+size_t index(const string& tok){
+    if (tok.empty()||tok.find_first_not_of("0123456789")!=string::npos||(tok[0]=='0'&&tok.size()>1))
+        throw std::logic_error("invalid array index "+tok);
+
+    return std::stoul(tok);
+}
+
+/* value at pointer tokens [0, n) in doc */
+struct Target{
+
+    /* span of value */
+    size_t b{0}, e{0};
+
+    /* span of member or element with separating comma
+     * to remove along with it */
+    size_t cut_b{0}, cut_e{0};
+
+    bool found{false};
+};
+
+Target locate(const string& doc, const std::vector<string>& tok, size_t n){
+
+    Target res;
+
+    res.b=skip_ws(doc, 0);
+    res.e=skip_value(doc, res.b);
+    res.found=true;
+
+    for (size_t i=0;i<n;++i){
+
+        size_t b=res.b;
+        size_t prev_end=string::npos;
+
+        res.found=false;
+
+        auto hit=[&](size_t mb, size_t vb, size_t ve){
+            res.b=vb;
+            res.e=ve;
+            res.found=true;
+
+            /* following comma or preceding one */
+            size_t p=skip_ws(doc, ve);
+
+            if (doc[p]==','){
+                res.cut_b=mb;
+                res.cut_e=skip_ws(doc, p+1);
+            } else if (prev_end!=string::npos){
+                res.cut_b=prev_end;
+                res.cut_e=ve;
+            } else {
+                res.cut_b=mb;
+                res.cut_e=ve;
+            }
+        };
+
+        if (doc[b]=='{'){
+            each_member(doc, b, [&](size_t kb, size_t ke, size_t vb, size_t ve){
+                if (same_key(doc, kb, ke, tok[i])){
+                    hit(kb-1, vb, ve);
+                    return false;
+                }
+
+                prev_end=ve;
+                return true;
+            });
+        } else if (doc[b]=='['&&tok[i]!="-"){
+            size_t idx=index(tok[i]), k=0;
+
+            each_elem(doc, b, [&](size_t vb, size_t ve){
+                if (k++==idx){
+                    hit(vb, vb, ve);
+                    return false;
+                }
+
+                prev_end=ve;
+                return true;
+            });
+        }
+
+        if (!res.found)
+            return res;
+    }
+
+    return res;
+}
+
+/* doc with [b, e) replaced by text */
+string splice(const string& doc, size_t b, size_t e, const string& text){
+    string res;
+
+    res.reserve(doc.size()-(e-b)+text.size());
+    res.append(doc, 0, b);
+    res+=text;
+    res.append(doc, e, string::npos);
+
+    return res;
+}
+
+string add(const string& doc, const string& path, const string& value){
+
+    std::vector<string> tok=pointer(path);
+
+    if (tok.empty())
+        return value;
+
+    Target t=locate(doc, tok, tok.size()-1);
+
+    if (!t.found)
+        throw std::logic_error("path not found "+path);
+
+    const string& last=tok.back();
+
+    if (doc[t.b]=='{'){
+
+        Target m=locate(doc, tok, tok.size());
+
+        if (m.found)
+            return splice(doc, m.b, m.e, value);
+
+        bool empty=true;
+
+        size_t end=each_member(doc, t.b, [&](size_t, size_t, size_t, size_t){
+            empty=false;
+            return true;
+        });
+
+        /* escape quotes and backslashes of new key */
+        string key;
+
+        for (auto c: last){
+            if (c=='"'||c=='\\')
+                key+='\\';
+            key+=c;
+        }
+
+        string member="\""+key+"\":"+value;
+
+        if (empty)
+            return splice(doc, t.b+1, t.b+1, member);
+
+        /* after last member */
+        size_t p=end;
+
+        while (::isspace(doc[p-1]))
+            --p;
+
+        return splice(doc, p, p, ","+member);
+    }
+
+    if (doc[t.b]!='[')
+        throw std::logic_error("parent is not a container "+path);
+
+    size_t count=0, at=string::npos, idx=(last=="-")?string::npos:index(last);
+    size_t last_end=string::npos;
+
+    each_elem(doc, t.b, [&](size_t vb, size_t ve){
+        if (count==idx)
+            at=vb;
+
+        ++count;
+        last_end=ve;
+        return true;
+    });
+
+    if (at!=string::npos)
+        return splice(doc, at, at, value+",");
+
+    if (idx!=string::npos&&idx!=count)
+        throw std::logic_error("index out of range "+path);
 
-        using std::vector;
+    if (last_end==string::npos)
+        return splice(doc, t.b+1, t.b+1, value);
 
-//        cout << "PARSE_ARR " << endl;
-//        cout << input << endl;
+    return splice(doc, last_end, last_end, ","+value);
+}
 
-        size_t left=input.find('[')+1;
-        size_t right=input.find_first_of(",]", left);
+string remove(const string& doc, const string& path){
 
-        JType type=detect_val_type(input.substr(left, right-left));
+    std::vector<string> tok=pointer(path);
 
-        if (type==JType::String){
+    if (tok.empty())
+        throw std::logic_error("cannot remove root");
 
-//            cout << "Detected type is String" << endl;
+    Target t=locate(doc, tok, tok.size());
 
-            std::vector<string> tmp;
+    if (!t.found)
+        throw std::logic_error("path not found "+path);
 
-            for (;right!=string::npos;left=input.find('"', right), right=input.find_first_of(",]", left))
-                tmp.push_back(Hlp::extract_str(input.substr(left, right-left)));
+    return splice(doc, t.cut_b, t.cut_e, "");
+}
 
+/* value text at path */
+string get(const string& doc, const string& path){
+    std::vector<string> tok=pointer(path);
+    Target t=locate(doc, tok, tok.size());
 
-            return new Arr<string>(tmp);
-        } else if (type==JType::Bool){
+    if (!t.found)
+        throw std::logic_error("path not found "+path);
 
-//            cout << "Detected type is Bool" << endl;
+    return doc.substr(t.b, t.e-t.b);
+}
 
-            std::vector<bool> tmp;
+/* equality for test operation (RFC 6902 4.6) of values at a[ab]
+ * and b[bb]: numbers by value, strings decoded, objects regardless
+ * of member order */
+bool equal(const string& a, size_t ab, const string& b, size_t bb){
 
-            for (left=input.find_first_of("tf", 0);left!=string::npos;left=input.find_first_of("tf", left+1))
-                tmp.push_back(input[left]=='t'?true:false);
+    auto num=[](char c){ return c=='-'||::isdigit((unsigned char)c); };
 
-            return new Arr<bool>(tmp);
-        } else if (type==JType::Null){
+    if (num(a[ab])||num(b[bb]))
+        return num(a[ab])&&num(b[bb])&&
+               std::strtold(a.c_str()+ab, nullptr)==std::strtold(b.c_str()+bb, nullptr);
 
-//            cout << "Detected type is Null" << endl;
+    if (a[ab]!=b[bb])
+        return false;
 
-            size_t count=1;
-            for (left=input.find(',', 0);left!=string::npos;++count, left=input.find(',', left+1));
+    size_t ae=skip_value(a, ab), be=skip_value(b, bb);
 
-            std::vector<Null_val> tmp(count);
-            return new Arr<Null_val>(tmp);
-        } else if (type==JType::Number){
+    switch (a[ab]) {
+    case '"':
+        return str_value(a, ab+1, ae-1)==str_value(b, bb+1, be-1);
+    case '[':{
+        std::vector<size_t> elems;
+
+        each_elem(b, bb, [&](size_t vb, size_t){
+            elems.push_back(vb);
+            return true;
+        });
 
-//            cout << "Detected type is Num" << endl;
+        size_t i=0;
+        bool res=true;
 
-            NType arr_nt=NType::i32;
+        each_elem(a, ab, [&](size_t vb, size_t){
+            res=(i<elems.size()&&equal(a, vb, b, elems[i++]));
+            return res;
+        });
 
-            vector<string> strnums;
+        return res&&i==elems.size();
+    }
+    case '{':{
+        size_t count=0;
+        bool res=true;
 
-            for (left=input.find_first_of("-123456789", 0);left!=string::npos;left=input.find_first_of("-1234567890", left+1)){
+        each_member(b, bb, [&](size_t, size_t, size_t, size_t){
+            ++count;
+            return true;
+        });
 
-                right=input.find_first_not_of("-+1234567890.eE", left);
+        each_member(a, ab, [&](size_t kb, size_t ke, size_t vb, size_t){
+            string name=str_value(a, kb, ke);
+            bool found=false;
 
-                strnums.push_back(input.substr(left, right-left));
+            each_member(b, bb, [&](size_t pkb, size_t pke, size_t pvb, size_t){
+                found=same_key(b, pkb, pke, name);
 
-                NType nt=detect_num_type(strnums.back());
+                if (found)
+                    res=equal(a, vb, b, pvb);
 
-                if (nt>arr_nt)
-                    arr_nt=nt;
+                return !found;
+            });
 
-                left=right;
-            }
+            res=res&&found;
+            --count;
 
-            if (arr_nt==NType::i32){
-                vector<int32_t> tmp;
-                for (auto x: strnums)
-                    tmp.push_back(std::stol(x));
+            return res;
+        });
 
-                return new Arr<int32_t>(tmp);
-            } else if (arr_nt==NType::i64){
-                vector<int64_t> tmp;
-                for (auto x: strnums)
-                    tmp.push_back(std::stoll(x));
+        return res&&count==0;
+    }
+    default:
+        /* true, false, null */
+        return ae-ab==be-bb&&a.compare(ab, ae-ab, b, bb, be-bb)==0;
+    }
+}
 
-                return new Arr<int64_t>(tmp);
-            } else if (arr_nt==NType::d){
-                vector<double> tmp;
-                for (auto x: strnums)
-                    tmp.push_back(std::stod(x));
+/* writes merge of patch value into target value (RFC 7386),
+ * tb==string::npos stands for missing target */
+void merge(const string& doc, size_t tb, const string& patch, size_t pb, size_t pe, string& out){
 
-                return new Arr<double>(tmp);
-            } else {
-                vector<long double> tmp;
-                for (auto x: strnums)
-                    tmp.push_back(std::stold(x));
+    if (patch[pb]!='{'){
+        out+=minify(patch, pb, pe);
+        return;
+    }
+
+    bool obj=(tb!=string::npos&&doc[tb]=='{');
+
+    out+='{';
+
+    bool first=true;
 
-                return new Arr<long double>(tmp);
+    auto sep=[&](){
+        if (!first)
+            out+=',';
+        first=false;
+    };
+
+    /* members of target, changed or removed by patch */
+    if (obj){
+        each_member(doc, tb, [&](size_t kb, size_t ke, size_t vb, size_t ve){
+
+            size_t found_b=string::npos, found_e=0;
+            string name=str_value(doc, kb, ke);
+
+            each_member(patch, pb, [&](size_t pkb, size_t pke, size_t pvb, size_t pve){
+                if (same_key(patch, pkb, pke, name)){
+                    found_b=pvb;
+                    found_e=pve;
+                }
+                return true;
+            });
+
+            if (found_b==string::npos){
+                sep();
+                out.append(doc, kb-1, ve-kb+1);
+            } else if (patch[found_b]!='n'){
+                sep();
+                out.append(doc, kb-1, ke-kb+2);
+                out+=':';
+                merge(doc, vb, patch, found_b, found_e, out);
             }
 
-            return nullptr;
+            return true;
+        });
+    }
 
-        } else if (type==JType::Object){
+    /* members only in patch, of repeated keys only the last counts */
+    each_member(patch, pb, [&](size_t pkb, size_t pke, size_t pvb, size_t pve){
 
-//            cout << "Object detected" << endl;
+        if (patch[pvb]=='n')
+            return true;
 
-            vector<Obj*> tmp;
+        string name=str_value(patch, pkb, pke);
+        bool exists=false;
 
-            for (left=input.find('{', 0);left!=string::npos;left=input.find('{', right)){
-                right=Hlp::detect_closing_bracket(input, left+1);
+        each_member(patch, pb, [&](size_t kb, size_t ke, size_t, size_t){
+            exists=kb>pkb&&same_key(patch, kb, ke, name);
+            return !exists;
+        });
+
+        if (!exists&&obj){
+            each_member(doc, tb, [&](size_t kb, size_t ke, size_t, size_t){
+                exists=same_key(doc, kb, ke, name);
+                return !exists;
+            });
+        }
+
+        if (!exists){
+            sep();
+            out.append(patch, pkb-1, pke-pkb+2);
+            out+=':';
+            merge(doc, string::npos, patch, pvb, pve, out);
+        }
+
+        return true;
+    });
 
-                Obj* t=new Obj();
+    out+='}';
+}
+
+} //Hlp namespace
+
+/* Applies JSON Patch (RFC 6902) ops to document doc and returns the
+ * result. Values are inserted minified, the rest of doc is copied
+ * unchanged. Throws std::logic_error if an operation fails */
+string apply_patch(const string& doc, const string& ops){
+
+    Status st=validate(ops.data(), ops.size());
+
+    if (!st)
+        throw std::logic_error(string("patch: ")+st.reason+" "+std::to_string(st.offset));
+
+    size_t b=Hlp::skip_ws(ops, 0);
+
+    if (ops[b]!='[')
+        throw std::logic_error("patch has to be an array");
 
-                string val=input.substr(left, right-left+1);
+    string res=doc;
 
-                t->Parse(val);
-                t->toStr();
+    Hlp::each_elem(ops, b, [&](size_t ob, size_t){
 
-                tmp.push_back(t);
+        if (ops[ob]!='{')
+            throw std::logic_error("patch operation has to be an object "+std::to_string(ob));
+
+        string op, path, from, value;
+        bool has_value=false, has_from=false;
+
+        Hlp::each_member(ops, ob, [&](size_t kb, size_t ke, size_t vb, size_t ve){
+            string key=Hlp::str_value(ops, kb, ke);
+
+            if (key=="value"){
+                value=Hlp::minify(ops, vb, ve);
+                has_value=true;
+            } else if (ops[vb]=='"'){
+                if (key=="op")
+                    op=Hlp::str_value(ops, vb+1, ve-1);
+                else if (key=="path")
+                    path=Hlp::str_value(ops, vb+1, ve-1);
+                else if (key=="from"){
+                    from=Hlp::str_value(ops, vb+1, ve-1);
+                    has_from=true;
+                }
             }
 
-            return new Arr<Obj*>(tmp);
+            return true;
+        });
 
-        } else if (type==JType::Array){
+        if ((op=="add"||op=="replace"||op=="test")&&!has_value)
+            throw std::logic_error(op+" without value");
 
-        } else {
-//            cout << "SHIT" << endl;
-            return nullptr;
-        }
-    }
-};
+        if ((op=="move"||op=="copy")&&!has_from)
+            throw std::logic_error(op+" without from");
 
-template <>
-string Arr<Obj*>::toStr() const {
-    std::string res=enclose(m_name)+": ";
+        if (op=="add")
+            res=Hlp::add(res, path, value);
+        else if (op=="remove")
+            res=Hlp::remove(res, path);
+        else if (op=="replace"){
+            std::vector<string> tok=Hlp::pointer(path);
+            Hlp::Target t=Hlp::locate(res, tok, tok.size());
 
-    res+="[ ";
+            if (!t.found)
+                throw std::logic_error("path not found "+path);
 
-    for (size_t i=0;i<value.size()-1;++i){
-        res+=value[i]->toStr();
+            res=Hlp::splice(res, t.b, t.e, value);
+        } else if (op=="move"){
+            if (path.compare(0, from.size()+1, from+"/")==0)
+                throw std::logic_error("cannot move "+from+" into itself");
 
-        res+=", ";
-    }
+            value=Hlp::get(res, from);
+            res=Hlp::add(Hlp::remove(res, from), path, value);
+        } else if (op=="copy")
+            res=Hlp::add(res, path, Hlp::get(res, from));
+        else if (op=="test"){
+            std::vector<string> tok=Hlp::pointer(path);
+            Hlp::Target t=Hlp::locate(res, tok, tok.size());
+
+            if (!t.found)
+                throw std::logic_error("path not found "+path);
 
-    res+=value[value.size()-1]->toStr()+" ]";
+            if (!Hlp::equal(res, t.b, value, 0))
+                throw std::logic_error("test failed "+path);
+        } else throw std::logic_error("unknown operation "+op);
+
+        return true;
+    });
 
     return res;
 }
 
-template <>
-Arr<Obj*>::~Arr(){
-    for (auto x: value){
-        x->memfree();
-        delete x;
-    }
-}
+/* Applies JSON Merge Patch (RFC 7386) to document doc. Objects on
+ * the way to changed members are written again minified, all other
+ * values are copied unchanged */
+string merge_patch(const string& doc, const string& patch){
 
-/* Main Object (Document) */
+    Status st=validate(patch.data(), patch.size());
 
-struct JSON{
+    if (!st)
+        throw std::logic_error(string("patch: ")+st.reason+" "+std::to_string(st.offset));
 
-    JSON(){}
+    size_t pb=Hlp::skip_ws(patch, 0);
+    size_t tb=Hlp::skip_ws(doc, 0);
 
-    JSON(const std::string& name):m_obj(name){}
+    string res;
 
-    ~JSON(){
-        for (auto x: m_obj.props)
-            delete x;
-    }
+    res.reserve(doc.size()+patch.size());
 
-    void Parse(const std::string& input){
-        m_obj.Parse(input);
-    }
+    Hlp::merge(doc, tb, patch, pb, Hlp::skip_value(patch, pb), res);
 
-    prop& operator[](const std::string& name){
-        return m_obj[name];
+    return res;
+}
+
+/* Input reads a file block by block. Compressed files are detected
+ * by their magic bytes: gzip when built with JSONER_WITH_ZLIB, zstd
+ * with JSONER_WITH_ZSTD. Reading and decompression run on a separate
+ * thread which fills one of two buffers while the caller works on
+ * the other one */
+
+struct Input{
+
+    Input(const std::string& path, size_t block_size=1<<20)
+        :m_block(block_size){
+
+        m_file=fopen(path.c_str(), "rb");
+
+        if (!m_file)
+            throw std::runtime_error("cannot open "+path);
+
+        m_thread=std::thread(&Input::produce, this);
     }
 
-    Obj findObj(const std::string& name){
-        if (name==m_obj.m_name)
-            return m_obj;
+    Input(const Input&)=delete;
+    Input& operator=(const Input&)=delete;
 
-        for (auto x: m_obj.props){
-            if (x->m_name==name){
-                return *dynamic_cast<Obj*>(x);
-            }
+    ~Input(){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop=true;
         }
 
-        return Obj();
-    }
+        m_cond.notify_all();
+        m_thread.join();
 
-    void addProperty(const std::string& name, const int& value){
-        prop* ptr=new Num<double>(name, value);
-        m_obj.props.push_back(ptr);
+        fclose(m_file);
     }
 
-    void addProperty(const std::string& name, const double& value){
-        prop* ptr=new Num<double>(name, value);
-        m_obj.props.push_back(ptr);
-    }
+    /* swaps the next decompressed block into block, the old content
+     * of block is reused as a buffer. Returns false at the end */
+    bool read(std::string& block){
+        std::unique_lock<std::mutex> lock(m_mutex);
 
-    void addProperty(const std::string& name, const int64_t& value){
-        prop* ptr=new Num<int64_t>(name, value);
-        m_obj.props.push_back(ptr);
-    }
+        m_cond.wait(lock, [this]{ return m_count>0||m_done; });
 
-    void addProperty(const std::string& name, const long double& value){
-        prop* ptr=new Num<long double>(name, value);
-        m_obj.props.push_back(ptr);
-    }
+        if (m_count==0){
+            if (!m_error.empty())
+                throw std::runtime_error(m_error);
 
-    void addProperty(const std::string& name, char * const value){
-        prop* ptr=new Str(name, value);
-        m_obj.props.push_back(ptr);
-    }
+            return false;
+        }
 
-    void addProperty(const std::string& name, bool value){
-        prop* ptr=new Boo(name, value);
-        m_obj.props.push_back(ptr);
+        block.swap(m_slots[m_head]);
+        m_head^=1;
+        --m_count;
+
+        lock.unlock();
+        m_cond.notify_all();
+
+        return true;
     }
 
-    template <typename T>
-    void addProperty(const std::string& name, const std::vector<T>& tmp){
-        prop* ptr=new Arr<T>(tmp);
-        m_obj.props.push_back(ptr);
+    /* reads the rest of input into res */
+    void readAll(std::string& res){
+        res.clear();
+
+        while (read(m_tmp))
+            res+=m_tmp;
     }
 
-    /* Add object in text representation */
+    /* reads next line without '\n' into line, for NDJSON */
+    bool getline(std::string& line){
+        line.clear();
 
-    void addObject(const std::string& json){
-        Obj* ptr=new Obj();
+        for (;;){
+            size_t nl=m_line.find('\n', m_pos);
 
-        ptr->Parse(json);
+            if (nl!=string::npos){
+                line.append(m_line, m_pos, nl-m_pos);
+                m_pos=nl+1;
+                return true;
+            }
 
-        m_obj.props.push_back(ptr);
+            line.append(m_line, m_pos, string::npos);
+            m_pos=0;
+
+            if (!read(m_line)){
+                m_line.clear();
+                return !line.empty();
+            }
+        }
     }
 
-    /* op2 should be const but
-     * toStr is not working */
+    /* reads whole lines ending with complete top level values into
+     * res, up to the last such line of the current block. NDJSON is
+     * handed out block by block while the next one is decompressed,
+     * a single document comes at once. Whitespace after the last
+     * value comes alone at the end. Not to be mixed with getline */
+    bool readValues(std::string& res){
+        res.clear();
 
-    void addObject(const Obj& op2){
-        Obj *ptr=new Obj();
+        for (;;){
+            const char* d=m_line.data();
+            size_t cut=string::npos;
 
-        ptr->Parse(op2.toStr());
+            for (size_t i=m_scan;i<m_line.size();++i){
+                char c=d[i];
 
-        m_obj.props.push_back(ptr);
-    }
+                if (m_str){
+                    if (m_esc)
+                        m_esc=false;
+                    else if (c=='\\')
+                        m_esc=true;
+                    else if (c=='"')
+                        m_str=false;
 
-    std::string toStr(){
-        return m_obj.toStr();
-    }
+                    continue;
+                }
 
-    std::vector<prop*>::iterator begin(){
-        return m_obj.begin();
-    }
+                switch (c) {
+                case '"':
+                    m_str=true;
+                    m_value=true;
+                    break;
+                case '{':
+                case '[':
+                    ++m_depth;
+                    m_value=true;
+                    break;
+                case '}':
+                case ']':
+                    --m_depth;
+                    break;
+                case '\n':
+                    if (m_depth==0&&m_value){
+                        cut=i+1;
+                        m_value=false;
+                    }
+                    break;
+                case ' ':
+                case '\t':
+                case '\r':
+                    break;
+                default:
+                    m_value=true;
+                }
+            }
 
-    std::vector<prop*>::iterator end(){
-        return m_obj.end();
+            m_scan=m_line.size();
+
+            if (cut!=string::npos){
+                res.append(m_line, m_pos, cut-m_pos);
+                m_pos=cut;
+                return true;
+            }
+
+            res.append(m_line, m_pos, string::npos);
+            m_pos=m_scan=0;
+
+            if (!read(m_line)){
+                m_line.clear();
+                return !res.empty();
+            }
+        }
     }
 
 private:
-    Obj m_obj;
-};
 
-struct Jiter{
+    enum Format{
+        Plain,
+        Gzip,
+        Zstd
+    };
 
-    Jiter()=default;
+    /* decompression thread */
+    void produce(){
 
-    Jiter(std::vector<prop*>::iterator op2){
-        it=op2;
+        try {
+            unsigned char magic[4]={0};
+            size_t n=fread(magic, 1, 4, m_file);
+
+            m_in.assign((char*)magic, n);
+
+            Format f=Plain;
+
+            if (n>=2&&magic[0]==0x1f&&magic[1]==0x8b)
+                f=Gzip;
+            else if (n==4&&magic[0]==0x28&&magic[1]==0xb5&&magic[2]==0x2f&&magic[3]==0xfd)
+                f=Zstd;
+
+            if (f==Gzip)
+                produce_gzip();
+            else if (f==Zstd)
+                produce_zstd();
+            else produce_plain();
+
+        } catch (std::exception& e) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error=e.what();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done=true;
+        }
+
+        m_cond.notify_all();
     }
 
-    Jiter& operator=(std::vector<prop*>::iterator op2){
-        it=op2;
+    /* waits for a free slot, returns nullptr when stopped */
+    std::string* acquire(){
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_cond.wait(lock, [this]{ return m_count<2||m_stop; });
+
+        if (m_stop)
+            return nullptr;
+
+        std::string* res=&m_slots[(m_head+m_count)&1];
+
+        res->resize(m_block);
+
+        return res;
     }
 
-    Jiter& operator=(const Jiter& op2){
-        it=op2.it;
+    /* publishes slot filled with size bytes */
+    void commit(std::string* slot, size_t size){
+        slot->resize(size);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_count;
+        }
+
+        m_cond.notify_all();
     }
 
-    Jiter& operator++(){
-        ++it;
+    /* reads more compressed input into m_in, false at end of file */
+    bool refill(){
+        m_in.resize(m_block);
+
+        size_t n=fread(&m_in[0], 1, m_block, m_file);
+
+        m_in.resize(n);
+
+        if (ferror(m_file))
+            throw std::runtime_error("read error");
+
+        return n>0;
     }
 
-    prop* operator->(){
-        return (*it);
+    void produce_plain(){
+        size_t have=m_in.size();
+
+        for (;;){
+            std::string* slot=acquire();
+
+            if (!slot)
+                return;
+
+            memcpy(&(*slot)[0], m_in.data(), have);
+
+            size_t n=have+fread(&(*slot)[have], 1, m_block-have, m_file);
+            have=0;
+
+            if (ferror(m_file))
+                throw std::runtime_error("read error");
+
+            if (n==0)
+                return;
+
+            commit(slot, n);
+        }
     }
 
-    bool operator==(const Jiter& op2){
-        return it==op2.it;
+#ifdef JSONER_WITH_ZLIB
+
+    void produce_gzip(){
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+
+        /* 15+32 accepts both gzip and zlib headers */
+        if (inflateInit2(&z, 15+32)!=Z_OK)
+            throw std::runtime_error("inflateInit failed");
+
+        z.next_in=(Bytef*)&m_in[0];
+        z.avail_in=m_in.size();
+
+        bool eof=false;
+        bool end=false;
+
+        try {
+            while (!end){
+                std::string* slot=acquire();
+
+                if (!slot)
+                    break;
+
+                z.next_out=(Bytef*)&(*slot)[0];
+                z.avail_out=m_block;
+
+                while (z.avail_out>0){
+
+                    if (z.avail_in==0&&!eof){
+                        eof=!refill();
+                        z.next_in=(Bytef*)&m_in[0];
+                        z.avail_in=m_in.size();
+                    }
+
+                    int ret=inflate(&z, Z_NO_FLUSH);
+
+                    if (ret==Z_STREAM_END){
+                        /* concatenated gzip members */
+                        if (z.avail_in==0&&!eof){
+                            eof=!refill();
+                            z.next_in=(Bytef*)&m_in[0];
+                            z.avail_in=m_in.size();
+                        }
+
+                        if (z.avail_in==0){
+                            end=true;
+                            break;
+                        }
+
+                        inflateReset(&z);
+                    } else if (ret==Z_BUF_ERROR&&eof&&z.avail_in==0)
+                        throw std::runtime_error("truncated gzip input");
+                    else if (ret!=Z_OK&&ret!=Z_BUF_ERROR)
+                        throw std::runtime_error(string("gzip: ")+(z.msg?z.msg:"inflate failed"));
+                }
+
+                size_t n=m_block-z.avail_out;
+
+                if (n==0)
+                    break;
+
+                commit(slot, n);
+            }
+        } catch (...) {
+            inflateEnd(&z);
+            throw;
+        }
+
+        inflateEnd(&z);
     }
 
-    bool operator!=(const Jiter& op2){
-        return it!=op2.it;
+#else
+
+    void produce_gzip(){
+        throw std::runtime_error("gzip input, built without zlib");
     }
 
-    Obj* getObj(){
-        return dynamic_cast<Obj*>(*it);
+#endif
+
+#ifdef JSONER_WITH_ZSTD
+
+    void produce_zstd(){
+        ZSTD_DStream* z=ZSTD_createDStream();
+
+        if (!z)
+            throw std::runtime_error("ZSTD_createDStream failed");
+
+        ZSTD_inBuffer in={m_in.data(), m_in.size(), 0};
+        bool eof=false;
+
+        /* 0 once a frame is decoded and flushed */
+        size_t ret=1;
+
+        try {
+            for (;;){
+                std::string* slot=acquire();
+
+                if (!slot)
+                    break;
+
+                ZSTD_outBuffer out={&(*slot)[0], m_block, 0};
+
+                while (out.pos<out.size){
+
+                    if (in.pos==in.size&&!eof){
+                        eof=!refill();
+                        in={m_in.data(), m_in.size(), 0};
+                    }
+
+                    /* last frame is decoded and flushed */
+                    if (eof&&in.pos==in.size&&ret==0)
+                        break;
+
+                    ret=ZSTD_decompressStream(z, &out, &in);
+
+                    if (ZSTD_isError(ret))
+                        throw std::runtime_error(string("zstd: ")+ZSTD_getErrorName(ret));
+
+                    /* after the end of input the decoder is called with no
+                     * input until it leaves room in out, which means it
+                     * has flushed everything it buffered */
+                    if (eof&&in.pos==in.size&&out.pos<out.size)
+                        break;
+                }
+
+                if (out.pos==0){
+                    if (ret!=0)
+                        throw std::runtime_error("truncated zstd input");
+                    break;
+                }
+
+                commit(slot, out.pos);
+            }
+        } catch (...) {
+            ZSTD_freeDStream(z);
+            throw;
+        }
+
+        ZSTD_freeDStream(z);
     }
 
-    bool isNull(){
-        return (*it)==nullptr;
+#else
+
+    void produce_zstd(){
+        throw std::runtime_error("zstd input, built without zstd");
     }
 
-private:
-    std::vector<prop*>::iterator it;
+#endif
+
+    FILE* m_file;
+    size_t m_block;
+
+    /* compressed input */
+    std::string m_in;
+
+    /* ring of two blocks, m_count of them filled from m_head */
+    std::string m_slots[2];
+    size_t m_head{0};
+    size_t m_count{0};
+    bool m_done{false};
+    bool m_stop{false};
+    std::string m_error;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+
+    /* used by readAll, getline and readValues */
+    std::string m_tmp;
+    std::string m_line;
+    size_t m_pos{0};
+
+    /* readValues scanned m_line up to m_scan, m_depth brackets
+     * are open there, m_value is set if a value started since
+     * the last cut */
+    size_t m_scan{0};
+    long m_depth{0};
+    bool m_str{false};
+    bool m_esc{false};
+    bool m_value{false};
 };
 
 } //JSON namespace
@@ -4,36 +4,234 @@
 #include <streambuf>
 #include <fstream>
 #include <string.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include "jsoner.h"
 
-#define BUFF_SIZE 4096
-
 using namespace std;
 
 using namespace J;
 
+/* reads whole file into res, compressed files are decompressed */
+bool read_file(const char* path, string& res){
+    try {
+        Input in(path);
+
+        in.readAll(res);
+    } catch (exception& e) {
+        cerr << path << ": " << e.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+/* moves error of a chunk to its place in the file,
+ * chunks from Input::readValues start at a new line */
+void shift(Status& st, size_t offset, size_t lines){
+    st.offset+=offset;
+    st.line+=lines;
+}
+
+/* validates whole file at once, it holds one top level value
+ * so a single document can't be split into chunks to validate
+ * while the rest is decompressed */
+Status validate_file(const char* path, size_t max_depth){
+    Input in(path);
+    string data;
+
+    in.readAll(data);
+
+    return validate(data.data(), data.size(), max_depth);
+}
+
+/* jsoner --validate [--max-depth=N] files... */
+int validate_files(int argc, char **argv){
+    size_t max_depth=512;
+    int failed=0;
+
+    for (int i=2;i<argc;++i){
+
+        if (!strncmp(argv[i], "--max-depth=", 12)){
+            max_depth=strtoul(argv[i]+12, nullptr, 10);
+            continue;
+        }
+
+        Status st;
+
+        try {
+            st=validate_file(argv[i], max_depth);
+        } catch (exception& e) {
+            cerr << argv[i] << ": " << e.what() << endl;
+            ++failed;
+            continue;
+        }
+
+        if (st)
+            cout << argv[i] << ": ok" << endl;
+        else {
+            cout << argv[i] << ":" << st.line << ":" << st.column
+                 << ": " << st.reason << " (offset " << st.offset << ")" << endl;
+            ++failed;
+        }
+    }
+
+    return failed?1:0;
+}
+
+/* result of transcoding one file */
+struct Job{
+    string out;
+    string error;
+    size_t size{0};
+    bool ready{false};
+};
+
+/* jsoner --minify|--pretty[=N]|--ndjson files...
+ * files are transcoded in parallel without building tree and
+ * written to stdout in the order they were given. NDJSON files
+ * are scanned chunk by chunk while the next one is decompressed,
+ * a single document is scanned once it is read whole */
+int transcode_files(int argc, char **argv){
+    int indent=-1;
+    bool lines=false;
+
+    if (!strncmp(argv[1], "--pretty", 8))
+        indent=argv[1][8]=='='?atoi(argv[1]+9):4;
+    else if (!strcmp(argv[1], "--ndjson"))
+        lines=true;
+
+    vector<Job> jobs(argc-2);
+
+    atomic<size_t> next{0};
+    mutex m;
+    condition_variable cv;
+
+    auto work=[&](){
+        string data;
+
+        for (size_t i;(i=next++)<jobs.size();){
+            Job& job=jobs[i];
+
+            try {
+                Input in(argv[i+2]);
+                Writer w(job.out, indent, lines);
+                Status st;
+                size_t nl=0;
+                bool value=false;
+
+                while (st&&in.readValues(data)){
+
+                    /* whitespace after the last value */
+                    if (value&&data.find_first_not_of(" \t\r\n")==string::npos)
+                        break;
+
+                    st=Scanner<Writer>(data.data(), data.size(), w, 512, true).run();
+                    value=true;
+
+                    if (!st)
+                        shift(st, job.size, nl);
+
+                    job.size+=data.size();
+                    nl+=count(data.begin(), data.end(), '\n');
+                }
+
+                if (!value)
+                    st=Scanner<Writer>(data.data(), 0, w, 512, true).run();
+
+                if (!st){
+                    job.out.clear();
+                    job.error=":"+to_string(st.line)+":"+to_string(st.column)+": "+st.reason;
+                }
+            } catch (exception& e) {
+                job.error=string(": ")+e.what();
+            }
+
+            {
+                lock_guard<mutex> lock(m);
+                job.ready=true;
+            }
+
+            cv.notify_all();
+        }
+    };
+
+    auto start=chrono::steady_clock::now();
+
+    size_t n=min<size_t>(max(1u, thread::hardware_concurrency()), jobs.size());
+    vector<thread> workers;
+
+    for (size_t i=0;i<n;++i)
+        workers.emplace_back(work);
+
+    int failed=0;
+    size_t total=0;
+
+    for (size_t i=0;i<jobs.size();++i){
+        {
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [&]{ return jobs[i].ready; });
+        }
+
+        if (!jobs[i].error.empty()){
+            cerr << argv[i+2] << jobs[i].error << endl;
+            ++failed;
+        }
+
+        fwrite(jobs[i].out.data(), 1, jobs[i].out.size(), stdout);
+
+        total+=jobs[i].size;
+        string().swap(jobs[i].out);
+    }
+
+    for (auto& x: workers)
+        x.join();
+
+    fflush(stdout);
+
+    double sec=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+    cerr << argv[1]+2 << ": " << jobs.size() << " files, " << fixed << setprecision(1)
+         << total/1e6 << " MB in " << setprecision(3) << sec << " s, "
+         << setprecision(1) << total/1e6/sec << " MB/s" << endl;
+
+    return failed?1:0;
+}
+
+void usage(const char* name){
+    cout << "usage " << name << " [.json]" << endl;
+    cout << "      " << name << " --validate [--max-depth=N] [.json]..." << endl;
+    cout << "      " << name << " --minify|--pretty[=N]|--ndjson [.json]..." << endl;
+    exit(1);
+}
+
 int main(int argc, char **argv)
 {
-    fstream in;
-    char buff[BUFF_SIZE];
+    if (argc>1&&!strcmp(argv[1], "--validate")){
+        if (argc==2||(argc==3&&!strncmp(argv[2], "--max-depth=", 12)))
+            usage(argv[0]);
 
-    if (argc!=2){
-        cout << "usage " << argv[0] << " [.json]" << endl;
-        exit(1);
+        return validate_files(argc, argv);
     }
 
-    in.open(argv[1], ios_base::in);
+    if (argc>1&&(!strcmp(argv[1], "--minify")||!strcmp(argv[1], "--ndjson")||
+                 !strcmp(argv[1], "--pretty")||!strncmp(argv[1], "--pretty=", 9))){
+        if (argc==2)
+            usage(argv[0]);
 
-    if (!in){
-        cout << "cannot open file" << endl;
-        exit(1);
+        return transcode_files(argc, argv);
     }
 
-    in.read(buff, BUFF_SIZE);
+    if (argc!=2)
+        usage(argv[0]);
 
-    streamsize ret=in.gcount();
+    string line;
 
-    string line(buff, ret);
+    if (!read_file(argv[1], line))
+        exit(1);
 
     JSON test;
 
@@ -0,0 +1,85 @@
+/* parse_columns()+toCSV() has to keep values of records and write
+ * nulls, mismatched types and numbers past double range as empty */
+
+#include <cstdio>
+#include <sstream>
+#include "../jsoner.h"
+
+using namespace J;
+
+static int failed=0;
+
+void check(bool ok, const char* what){
+    if (!ok){
+        printf("FAIL: %s\n", what);
+        ++failed;
+    }
+}
+
+void csv(const std::string& input, const std::string& expected, const char* what){
+    std::ostringstream out;
+
+    parse_columns(input).toCSV(out);
+
+    if (out.str()!=expected){
+        printf("%s\n  expected:\n%s  got:\n%s", input.c_str(), expected.c_str(), out.str().c_str());
+        check(false, what);
+    }
+}
+
+int main(){
+    csv("[{\"id\": 1, \"name\": \"a\", \"ok\": true}, {\"id\": 2, \"name\": \"b, \\\"c\\\"\", \"ok\": false}]",
+        "id,name,ok\n1,a,true\n2,\"b, \"\"c\"\"\",false\n", "array of records");
+
+    csv("{\"id\": 1}\n{\"id\": 2, \"pos\": {\"x\": 5}}\n{\"id\": null, \"pos\": {\"x\": 6}}\n",
+        "id,pos.x\n1,\n2,5\n,6\n", "NDJSON with nested keys and nulls");
+
+    csv("[{\"v\": 1}, {\"v\": \"s\"}, {\"v\": [1, 2]}, {\"v\": 3}]",
+        "v\n1\n\n\n3\n", "mismatched types and arrays are null");
+
+    /* reals are written back in shortest form that reads the same */
+    csv("[{\"v\": 1}, {\"v\": 0.1}, {\"v\": -2.5e-8}, {\"v\": 1.7976931348623157e308}]",
+        "v\n1\n0.1\n-2.5e-08\n1.7976931348623157e+308\n", "reals");
+
+    csv("[{\"v\": 3000000000}, {\"v\": -9223372036854775808}]",
+        "v\n3000000000\n-9223372036854775808\n", "64 bit integers");
+
+    /* no inf in output */
+    csv("[{\"v\": 1.5}, {\"v\": 1e400}, {\"v\": -1e400}, {\"v\": 2}]",
+        "v\n1.5\n\n\n2\n", "reals past double range are null");
+
+    csv("[{\"v\": 1}, {\"v\": 1e400}]",
+        "v\n1\n\n", "integer column with value past double range");
+
+    csv("[{\"v\": 1}, {\"v\": 99999999999999999999}]",
+        "v\n1\n1e+20\n", "integer past int64 is real");
+
+    /* values read back from CSV are the ones parsed from JSON */
+    std::string input="[";
+
+    for (int i=0;i<1000;++i)
+        input+=(i?",":"")+std::string("{\"v\": ")+std::to_string(i*0.37-50)+"e-3}";
+
+    input+="]";
+
+    Columns cols=parse_columns(input);
+    std::ostringstream out;
+    cols.toCSV(out);
+
+    std::istringstream in(out.str());
+    std::string line;
+    std::getline(in, line);
+
+    size_t r=0;
+    bool same=true;
+
+    while (std::getline(in, line))
+        same=same&&r<cols.rows&&std::strtod(line.c_str(), nullptr)==cols.cols[0].reals[r++];
+
+    check(same&&r==1000, "reals read back from CSV");
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}
@@ -0,0 +1,73 @@
+/* with keepFragments() toStr() has to give the same text as without
+ * it after arrays or objects in them were changed or parsed again */
+
+#include <cstdio>
+#include "../jsoner.h"
+
+using namespace J;
+
+static int failed=0;
+
+void check(bool ok, const char* what){
+    if (!ok){
+        printf("FAIL: %s\n", what);
+        ++failed;
+    }
+}
+
+/* compares doc with a fresh parse of expected */
+void same(const JSON& doc, const std::string& expected, const char* what){
+    JSON plain;
+    plain.Parse(expected);
+
+    if (doc.toStr()!=plain.toStr()){
+        printf("  expected: %s\n  got:      %s\n", plain.toStr().c_str(), doc.toStr().c_str());
+        check(false, what);
+    }
+}
+
+int main(){
+    const std::string first="{\"v\": [1, 2], \"s\": [\"a\"], \"objs\": [{\"a\": 1}, {\"a\": 2}], \"mix\": [[1], {\"b\": 1}]}";
+    const std::string second="{\"v\": [3, 4], \"s\": [\"b\"], \"objs\": [{\"a\": 3}, {\"a\": 4}], \"mix\": [[2], {\"b\": 2}]}";
+
+    JSON doc;
+    doc.keepFragments();
+    doc.Parse(first);
+
+    same(doc, first, "first write");
+    same(doc, first, "unchanged write");
+
+    /* array text is kept, so a change without touch() isn't seen
+     * even when the object holding it is written again */
+    auto v=(Arr<int32_t>*)&doc["v"];
+    v->value[0]=5;
+    doc["s"].touch();
+
+    same(doc, first, "array fragment kept");
+
+    v->touch();
+
+    same(doc, "{\"v\": [5, 2], \"s\": [\"a\"], \"objs\": [{\"a\": 1}, {\"a\": 2}], \"mix\": [[1], {\"b\": 1}]}", "touched array");
+
+    /* setter of member of an object in array */
+    auto objs=(Arr<Obj*>*)&doc["objs"];
+    ((Num<int32_t>*)objs->value[1]->findProperty("a"))->set(7);
+
+    same(doc, "{\"v\": [5, 2], \"s\": [\"a\"], \"objs\": [{\"a\": 1}, {\"a\": 7}], \"mix\": [[1], {\"b\": 1}]}", "object in array");
+
+    /* arrays reused by reset() */
+    doc.reset();
+    doc.Parse(second);
+
+    same(doc, second, "reset and Parse");
+
+    doc.reset();
+    doc.Parse(first);
+
+    same(doc, first, "reset and Parse again");
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}
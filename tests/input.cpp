@@ -0,0 +1,159 @@
+/* Input has to give back the same text from plain, gzip and zstd
+ * files of several MB, with any block size, and reject truncated
+ * compressed files */
+
+#include <cstdio>
+#include "../jsoner.h"
+
+using namespace J;
+
+static int failed=0;
+
+void check(bool ok, const char* what){
+    if (!ok){
+        printf("FAIL: %s\n", what);
+        ++failed;
+    }
+}
+
+void save(const std::string& path, const std::string& data){
+    FILE* f=fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+/* reads path in all ways Input has and compares with expected */
+void same(const std::string& path, const std::string& expected, const char* what){
+
+    for (size_t block: {size_t(1<<20), size_t(4096), size_t(1000)}){
+        std::string res, part;
+
+        {
+            Input in(path, block);
+            in.readAll(res);
+        }
+
+        check(res==expected, what);
+
+        res.clear();
+
+        {
+            Input in(path, block);
+
+            while (in.read(part))
+                res+=part;
+        }
+
+        check(res==expected, what);
+
+        res.clear();
+
+        {
+            Input in(path, block);
+
+            while (in.readValues(part))
+                res+=part;
+        }
+
+        check(res==expected, what);
+
+        res.clear();
+
+        {
+            Input in(path, block);
+
+            while (in.getline(part))
+                res+=part+"\n";
+        }
+
+        check(res==expected, what);
+    }
+}
+
+/* reading path has to throw */
+void broken(const std::string& path, const char* what){
+    bool thrown=false;
+
+    try {
+        Input in(path);
+        std::string res;
+        in.readAll(res);
+    } catch (std::runtime_error&) {
+        thrown=true;
+    }
+
+    check(thrown, what);
+}
+
+int main(){
+    /* NDJSON which compresses well, so decoders buffer a lot of
+     * output for little input */
+    std::string data;
+
+    for (size_t i=0;data.size()<(8<<20);++i)
+        data+="{\"id\": "+std::to_string(i)+", \"name\": \"record\", \"tags\": [\"a\", \"b\", \"c\"], \"pos\": {\"x\": "
+              +std::to_string(i%100)+", \"y\": 0}}\n";
+
+    save("input_test.json", data);
+    same("input_test.json", data, "plain");
+
+#ifdef JSONER_WITH_ZSTD
+    {
+        std::string z(ZSTD_compressBound(data.size()), 0);
+        size_t n=ZSTD_compress(&z[0], z.size(), data.data(), data.size(), 3);
+        check(!ZSTD_isError(n), "ZSTD_compress");
+        z.resize(n);
+
+        save("input_test.json.zst", z);
+        same("input_test.json.zst", data, "zstd");
+
+        /* concatenated frames are read as one stream */
+        save("input_test.json.zst", z+z);
+        same("input_test.json.zst", data+data, "zstd frames");
+
+        save("input_test.json.zst", z.substr(0, z.size()/2));
+        broken("input_test.json.zst", "truncated zstd");
+
+        remove("input_test.json.zst");
+    }
+#endif
+
+#ifdef JSONER_WITH_ZLIB
+    {
+        z_stream s;
+        memset(&s, 0, sizeof(s));
+
+        /* 15+16 writes gzip header */
+        deflateInit2(&s, 6, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY);
+
+        std::string z(deflateBound(&s, data.size()), 0);
+
+        s.next_in=(Bytef*)data.data();
+        s.avail_in=data.size();
+        s.next_out=(Bytef*)&z[0];
+        s.avail_out=z.size();
+
+        check(deflate(&s, Z_FINISH)==Z_STREAM_END, "deflate");
+        z.resize(s.total_out);
+        deflateEnd(&s);
+
+        save("input_test.json.gz", z);
+        same("input_test.json.gz", data, "gzip");
+
+        save("input_test.json.gz", z+z);
+        same("input_test.json.gz", data+data, "gzip members");
+
+        save("input_test.json.gz", z.substr(0, z.size()/2));
+        broken("input_test.json.gz", "truncated gzip");
+
+        remove("input_test.json.gz");
+    }
+#endif
+
+    remove("input_test.json");
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}
@@ -0,0 +1,156 @@
+/* apply_patch (RFC 6902) and merge_patch (RFC 7386) on text have
+ * to give the documents of the RFC examples, results are compared
+ * minified */
+
+#include <cstdio>
+#include "../jsoner.h"
+
+using namespace J;
+
+static int failed=0;
+
+void check(bool ok, const char* what){
+    if (!ok){
+        printf("FAIL: %s\n", what);
+        ++failed;
+    }
+}
+
+std::string norm(const std::string& str){
+    return Hlp::minify(str, Hlp::skip_ws(str, 0), str.size());
+}
+
+void patch(const std::string& doc, const std::string& ops, const std::string& expected, const char* what){
+    std::string res;
+
+    try {
+        res=apply_patch(doc, ops);
+    } catch (std::exception& e) {
+        res=e.what();
+    }
+
+    if (norm(res)!=norm(expected)){
+        printf("%s\n  %s\n  expected: %s\n  got:      %s\n", doc.c_str(), ops.c_str(), expected.c_str(), res.c_str());
+        check(false, what);
+    }
+}
+
+/* ops have to throw */
+void fails(const std::string& doc, const std::string& ops, const char* what){
+    bool thrown=false;
+
+    try {
+        apply_patch(doc, ops);
+    } catch (std::logic_error&) {
+        thrown=true;
+    }
+
+    check(thrown, what);
+}
+
+void merge(const std::string& doc, const std::string& patch, const std::string& expected, const char* what){
+    std::string res=merge_patch(doc, patch);
+
+    if (norm(res)!=norm(expected)){
+        printf("%s\n  %s\n  expected: %s\n  got:      %s\n", doc.c_str(), patch.c_str(), expected.c_str(), res.c_str());
+        check(false, what);
+    }
+}
+
+int main(){
+    /* add */
+    patch("{\"foo\": \"bar\"}", "[{\"op\": \"add\", \"path\": \"/baz\", \"value\": \"qux\"}]",
+          "{\"foo\": \"bar\", \"baz\": \"qux\"}", "add member");
+    patch("{\"foo\": [\"bar\", \"baz\"]}", "[{\"op\": \"add\", \"path\": \"/foo/1\", \"value\": \"qux\"}]",
+          "{\"foo\": [\"bar\", \"qux\", \"baz\"]}", "add at index");
+    patch("{\"foo\": [\"bar\"]}", "[{\"op\": \"add\", \"path\": \"/foo/0\", \"value\": 1}]",
+          "{\"foo\": [1, \"bar\"]}", "add at first index");
+    patch("{\"foo\": [\"bar\"]}", "[{\"op\": \"add\", \"path\": \"/foo/1\", \"value\": 1}]",
+          "{\"foo\": [\"bar\", 1]}", "add at size");
+    patch("{\"foo\": [1, 2]}", "[{\"op\": \"add\", \"path\": \"/foo/-\", \"value\": [3]}]",
+          "{\"foo\": [1, 2, [3]]}", "add at -");
+    patch("{\"foo\": []}", "[{\"op\": \"add\", \"path\": \"/foo/-\", \"value\": 1}]",
+          "{\"foo\": [1]}", "add to empty array");
+    patch("{}", "[{\"op\": \"add\", \"path\": \"/a\", \"value\": {\"b\": null}}]",
+          "{\"a\": {\"b\": null}}", "add to empty object");
+    patch("{\"foo\": 1}", "[{\"op\": \"add\", \"path\": \"/foo\", \"value\": 2}]",
+          "{\"foo\": 2}", "add replaces member");
+    patch("{\"a/b\": 1, \"m~n\": 2}", "[{\"op\": \"add\", \"path\": \"/a~1b\", \"value\": 3}, {\"op\": \"add\", \"path\": \"/m~0n\", \"value\": 4}]",
+          "{\"a/b\": 3, \"m~n\": 4}", "escaped pointer");
+    fails("{\"foo\": [1]}", "[{\"op\": \"add\", \"path\": \"/foo/2\", \"value\": 1}]", "add past size");
+    fails("{\"foo\": 1}", "[{\"op\": \"add\", \"path\": \"/bar/baz\", \"value\": 1}]", "add to missing parent");
+
+    /* remove, commas around the removed value */
+    patch("{\"a\": 1, \"b\": 2, \"c\": 3}", "[{\"op\": \"remove\", \"path\": \"/a\"}]",
+          "{\"b\": 2, \"c\": 3}", "remove first member");
+    patch("{\"a\": 1, \"b\": 2, \"c\": 3}", "[{\"op\": \"remove\", \"path\": \"/b\"}]",
+          "{\"a\": 1, \"c\": 3}", "remove middle member");
+    patch("{\"a\": 1, \"b\": 2, \"c\": 3}", "[{\"op\": \"remove\", \"path\": \"/c\"}]",
+          "{\"a\": 1, \"b\": 2}", "remove last member");
+    patch("{\"a\": 1}", "[{\"op\": \"remove\", \"path\": \"/a\"}]",
+          "{}", "remove only member");
+    patch("{\"a\": [1, 2, 3]}", "[{\"op\": \"remove\", \"path\": \"/a/2\"}, {\"op\": \"remove\", \"path\": \"/a/0\"}]",
+          "{\"a\": [2]}", "remove elements");
+    fails("{\"a\": 1}", "[{\"op\": \"remove\", \"path\": \"/b\"}]", "remove missing");
+
+    /* replace, move, copy */
+    patch("{\"baz\": \"qux\", \"foo\": \"bar\"}", "[{\"op\": \"replace\", \"path\": \"/baz\", \"value\": \"boo\"}]",
+          "{\"baz\": \"boo\", \"foo\": \"bar\"}", "replace");
+    patch("{\"foo\": {\"bar\": \"baz\", \"waldo\": \"fred\"}, \"qux\": {\"corge\": \"grault\"}}",
+          "[{\"op\": \"move\", \"from\": \"/foo/waldo\", \"path\": \"/qux/thud\"}]",
+          "{\"foo\": {\"bar\": \"baz\"}, \"qux\": {\"corge\": \"grault\", \"thud\": \"fred\"}}", "move member");
+    patch("{\"foo\": [\"all\", \"grass\", \"cows\", \"eat\"]}", "[{\"op\": \"move\", \"from\": \"/foo/1\", \"path\": \"/foo/3\"}]",
+          "{\"foo\": [\"all\", \"cows\", \"eat\", \"grass\"]}", "move element");
+    patch("{\"a\": 1, \"ab\": 2}", "[{\"op\": \"move\", \"from\": \"/a\", \"path\": \"/abc\"}]",
+          "{\"ab\": 2, \"abc\": 1}", "move to path with same prefix");
+    patch("{\"a\": {\"b\": 1}}", "[{\"op\": \"move\", \"from\": \"/a\", \"path\": \"/a\"}]",
+          "{\"a\": {\"b\": 1}}", "move to itself");
+    fails("{\"a\": {\"b\": 1}}", "[{\"op\": \"move\", \"from\": \"/a\", \"path\": \"/a/c\"}]", "move into itself");
+    patch("{\"a\": [1]}", "[{\"op\": \"copy\", \"from\": \"/a\", \"path\": \"/b\"}]",
+          "{\"a\": [1], \"b\": [1]}", "copy");
+
+    /* test compares values, not text */
+    patch("{\"a\": {\"x\": 1, \"y\": [1, 2]}}", "[{\"op\": \"test\", \"path\": \"/a\", \"value\": {\"y\": [1, 2], \"x\": 1}}]",
+          "{\"a\": {\"x\": 1, \"y\": [1, 2]}}", "test with other member order");
+    patch("{\"a\": 1}", "[{\"op\": \"test\", \"path\": \"/a\", \"value\": 1.0}]",
+          "{\"a\": 1}", "test 1 and 1.0");
+    patch("{\"a\": 100}", "[{\"op\": \"test\", \"path\": \"/a\", \"value\": 1e2}]",
+          "{\"a\": 100}", "test 100 and 1e2");
+    patch("{\"a\": \"\\u0041\"}", "[{\"op\": \"test\", \"path\": \"/a\", \"value\": \"A\"}]",
+          "{\"a\": \"\\u0041\"}", "test escaped string");
+    fails("{\"a\": [1, 2]}", "[{\"op\": \"test\", \"path\": \"/a\", \"value\": [2, 1]}]", "test element order");
+    fails("{\"a\": {\"x\": 1}}", "[{\"op\": \"test\", \"path\": \"/a\", \"value\": {\"x\": 1, \"y\": 2}}]", "test extra member");
+    fails("{\"a\": 1}", "[{\"op\": \"test\", \"path\": \"/a\", \"value\": \"1\"}]", "test other type");
+
+    /* failed op leaves nothing applied */
+    fails("{\"a\": 1}", "[{\"op\": \"add\", \"path\": \"/b\", \"value\": 1}, {\"op\": \"test\", \"path\": \"/a\", \"value\": 2}]", "failed test");
+    fails("{\"a\": 1}", "[{\"op\": \"nop\", \"path\": \"/a\"}]", "unknown operation");
+
+    /* merge patch, RFC 7386 appendix A */
+    merge("{\"a\": \"b\"}", "{\"a\": \"c\"}", "{\"a\": \"c\"}", "merge replace");
+    merge("{\"a\": \"b\"}", "{\"b\": \"c\"}", "{\"a\": \"b\", \"b\": \"c\"}", "merge add");
+    merge("{\"a\": \"b\"}", "{\"a\": null}", "{}", "merge remove with null");
+    merge("{\"a\": \"b\", \"b\": \"c\"}", "{\"a\": null}", "{\"b\": \"c\"}", "merge remove one");
+    merge("{\"a\": [\"b\"]}", "{\"a\": \"c\"}", "{\"a\": \"c\"}", "merge array by value");
+    merge("{\"a\": \"c\"}", "{\"a\": [\"b\"]}", "{\"a\": [\"b\"]}", "merge value by array");
+    merge("{\"a\": {\"b\": \"c\"}}", "{\"a\": {\"b\": \"d\", \"c\": null}}", "{\"a\": {\"b\": \"d\"}}", "merge nested");
+    merge("{\"a\": [{\"b\": \"c\"}]}", "{\"a\": [1]}", "{\"a\": [1]}", "merge array of objects");
+    merge("[\"a\", \"b\"]", "[\"c\", \"d\"]", "[\"c\", \"d\"]", "merge arrays");
+    merge("{\"a\": \"b\"}", "[\"c\"]", "[\"c\"]", "merge object by array");
+    merge("{\"a\": \"foo\"}", "null", "null", "merge null");
+    merge("{\"a\": \"foo\"}", "\"bar\"", "\"bar\"", "merge string");
+    merge("{\"e\": null}", "{\"a\": 1}", "{\"e\": null, \"a\": 1}", "merge keeps null of target");
+    merge("[1, 2]", "{\"a\": \"b\", \"c\": null}", "{\"a\": \"b\"}", "merge object into array");
+    merge("{}", "{\"a\": {\"bb\": {\"ccc\": null}}}", "{\"a\": {\"bb\": {}}}", "merge nulls in new member");
+
+    /* of repeated keys in patch only the last counts */
+    merge("{\"a\": 1}", "{\"b\": 1, \"b\": 2}", "{\"a\": 1, \"b\": 2}", "merge repeated new key");
+    merge("{\"a\": 1}", "{\"a\": 2, \"a\": 3}", "{\"a\": 3}", "merge repeated key");
+    merge("{\"a\": 1}", "{\"b\": 1, \"b\": null}", "{\"a\": 1}", "merge repeated key ending with null");
+    merge("{\"a\": 1}", "{\"a\": null, \"a\": 2}", "{\"a\": 2}", "merge null then value");
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}
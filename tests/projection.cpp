@@ -0,0 +1,65 @@
+/* Parse(input, projection) keeps only members on the given paths
+ * and skips the others whole */
+
+#include <cstdio>
+#include "../jsoner.h"
+
+using namespace J;
+
+static int failed=0;
+
+void check(bool ok, const char* what){
+    if (!ok){
+        printf("FAIL: %s\n", what);
+        ++failed;
+    }
+}
+
+/* parses input with proj and compares toStr() with expected */
+void same(const Projection& proj, const std::string& input, const std::string& expected, const char* what){
+    JSON doc;
+
+    try {
+        doc.Parse(input, proj);
+    } catch (std::exception& e) {
+        printf("%s\n  error: %s\n", input.c_str(), e.what());
+        check(false, what);
+        return;
+    }
+
+    if (doc.toStr()!=expected){
+        printf("%s\n  got:      %s\n  expected: %s\n", input.c_str(), doc.toStr().c_str(), expected.c_str());
+        check(false, what);
+    }
+}
+
+int main(){
+    Projection proj{"id", "user.name", "user.tags"};
+
+    same(proj, "{\"id\": 1, \"x\": 2, \"user\": {\"name\": \"a\", \"age\": 3, \"tags\": [1, 2]}}",
+         "{\"id\": 1, \"user\": {\"name\": \"a\", \"tags\": [ 1, 2 ]}}", "members on paths");
+
+    same(proj, "{\"x\": {\"id\": 5}, \"id\": 7}", "{\"id\": 7}", "same key at other level");
+
+    /* skipped values with brackets, quotes and separators in strings */
+    same(proj, "{\"x\": \"}]{[\", \"y\": {\"s\": \"}\"}, \"z\": [\"]\", \"\\\"}\"], \"id\": 1}", "{\"id\": 1}", "brackets in skipped strings");
+    same(proj, "{\"a\\\"}\": 1, \"id\": 2}", "{\"id\": 2}", "escaped quote in skipped key");
+    same(proj, "{\"x\": \"a\\\\\", \"id\": 3}", "{\"id\": 3}", "escaped backslash before quote");
+
+    /* path through values which are not objects */
+    same(proj, "{\"user\": 5, \"id\": 1}", "{\"id\": 1}", "path through number");
+    same(proj, "{\"user\": [{\"name\": \"a\"}], \"id\": 1}", "{\"id\": 1}", "path through array");
+    same(proj, "{\"user\": \"{\\\"name\\\": 1}\", \"id\": 1}", "{\"id\": 1}", "path through string");
+    same(proj, "{\"user\": {\"age\": 1}, \"id\": 1}", "{\"id\": 1}", "nothing found in nested object");
+
+    /* leaf taken whole */
+    same(Projection{"user"}, "{\"id\": 1, \"user\": {\"name\": \"a\", \"n\": {\"m\": null}}}",
+         "{\"user\": {\"name\": \"a\", \"n\": {\"m\": null}}}", "object leaf");
+
+    same(Projection{}, "{\"id\": 1}", "{}", "empty projection");
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}
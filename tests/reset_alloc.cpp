@@ -0,0 +1,97 @@
+/* reset()+Parse(input, shape) has to reuse nodes and buffers
+ * of the previous record, so the loop doesn't allocate */
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../jsoner.h"
+
+static size_t allocations=0;
+
+void* operator new(size_t size){
+    ++allocations;
+
+    if (void* p=malloc(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+/* parses records in a loop with reset(), with or without shape,
+ * returns number of allocations after the first rounds */
+size_t count(const std::string* records, size_t n, bool with_shape){
+    J::JSON doc;
+    J::Shape shape;
+
+    /* first rounds build nodes and grow buffers */
+    for (size_t i=0;i<n;++i){
+        doc.reset();
+
+        if (with_shape)
+            doc.Parse(records[i], shape);
+        else doc.Parse(records[i]);
+    }
+
+    allocations=0;
+
+    for (size_t i=0;i<1000;++i){
+        doc.reset();
+
+        if (with_shape)
+            doc.Parse(records[i%n], shape);
+        else doc.Parse(records[i%n]);
+    }
+
+    size_t res=allocations;
+
+    /* last round parsed records[999%n], ids count from 1 */
+    if (doc["id"].getInt()!=(int64_t)(999%n+1)){
+        printf("wrong values after reuse\n");
+        res=~(size_t)0;
+    }
+
+    return res;
+}
+
+int main(){
+    const std::string flat[]={
+        "{\"id\": 1, \"name\": \"first record\", \"score\": 1.5, \"ok\": true, \"none\": null, \"pos\": {\"x\": 10, \"y\": 20}}",
+        "{\"id\": 2, \"name\": \"second\", \"score\": 2.25, \"ok\": false, \"none\": null, \"pos\": {\"x\": 11, \"y\": 21}}",
+        "{\"id\": 3, \"name\": \"third record\", \"score\": 3.125, \"ok\": true, \"none\": null, \"pos\": {\"x\": 12, \"y\": 22}}"
+    };
+
+    /* nested arrays, arrays of objects and of mixed values */
+    const std::string nested[]={
+        "{\"id\": 1, \"mix\": [[1, 2], [3, 4]], \"objs\": [{\"a\": 1}, {\"a\": {\"b\": [5]}}], \"any\": [1, \"s\", {\"c\": true}, null]}",
+        "{\"id\": 2, \"mix\": [[5, 6], [7, 8]], \"objs\": [{\"a\": 2}, {\"a\": {\"b\": [6]}}], \"any\": [2, \"t\", {\"c\": false}, null]}"
+    };
+
+    int failed=0;
+
+    auto run=[&](const char* name, const std::string* records, size_t n, bool with_shape){
+        size_t res=count(records, n, with_shape);
+
+        if (res){
+            printf("%s: reset()+Parse() allocated %zu times\n", name, res);
+            ++failed;
+        }
+    };
+
+    run("flat with shape", flat, 3, true);
+    run("flat", flat, 3, false);
+    run("nested with shape", nested, 2, true);
+    run("nested", nested, 2, false);
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}
@@ -0,0 +1,89 @@
+/* Parse(input, shape) has to give the same tree as Parse(input)
+ * and fall back to it when a record doesn't match the shape */
+
+#include <cstdio>
+#include "../jsoner.h"
+
+using namespace J;
+
+static int failed=0;
+
+void check(bool ok, const char* what){
+    if (!ok){
+        printf("FAIL: %s\n", what);
+        ++failed;
+    }
+}
+
+/* parses input with shape and compares with generic Parse */
+void same(Shape& shape, const std::string& input, const char* what){
+    JSON plain, shaped;
+
+    plain.Parse(input);
+    shaped.Parse(input, shape);
+
+    if (plain.toStr()!=shaped.toStr()){
+        printf("%s\n  plain:  %s\n  shaped: %s\n", input.c_str(), plain.toStr().c_str(), shaped.toStr().c_str());
+        check(false, what);
+    }
+}
+
+int main(){
+    Shape shape;
+
+    same(shape, "{\"id\": 1, \"name\": \"a\", \"ok\": true, \"none\": null, \"pos\": {\"x\": 1.5}, \"v\": [1, 2]}", "first record");
+    check(!shape.empty(), "shape recorded");
+
+    same(shape, "{\"id\": 2, \"name\": \"b\", \"ok\": false, \"none\": null, \"pos\": {\"x\": 2.5}, \"v\": [3]}", "matching record");
+
+    /* each of these doesn't match the shape of the previous one */
+    same(shape, "{\"name\": \"c\", \"id\": 3, \"ok\": true, \"none\": null, \"pos\": {\"x\": 1.5}, \"v\": []}", "other key order");
+    same(shape, "{\"name\": 4, \"id\": 3, \"ok\": true, \"none\": null, \"pos\": {\"x\": 1.5}, \"v\": []}", "other type");
+    same(shape, "{\"name\": 4, \"id\": 12345678901, \"ok\": true, \"none\": null, \"pos\": {\"x\": 1.5}, \"v\": []}", "wider number");
+    same(shape, "{\"name\": 4, \"id\": 1, \"ok\": true, \"none\": null, \"pos\": {\"x\": 1.5}, \"v\": [], \"extra\": 1}", "extra key");
+    same(shape, "{\"name\": 4, \"id\": 1, \"ok\": true, \"none\": null, \"pos\": {\"x\": 1.5}}", "missing key");
+    same(shape, "{\"name\": 4, \"id\": 1, \"ok\": true, \"none\": null, \"pos\": {\"y\": 1.5}}", "other nested key");
+    same(shape, "{\"name\": 4, \"id\": 1, \"ok\": true, \"none\": null, \"pos\": {\"y\": 1.5}}", "same again");
+
+    /* strings with brackets and separators */
+    same(shape, "{\"s\": \"{[,:]}\", \"n\": 1}", "brackets in string");
+    same(shape, "{\"s\": \"}],\", \"n\": 2}", "brackets in string with shape");
+
+    /* shape reused after reset() */
+    JSON doc;
+
+    for (int i=0;i<3;++i){
+        doc.reset();
+        doc.Parse("{\"s\": \"x\", \"n\": "+std::to_string(i)+"}", shape);
+    }
+
+    check(doc["n"].getInt()==2&&doc["s"].getStr()=="x", "values after reset()");
+
+    /* 10 digit values past int32 are widened, not wrapped */
+    Shape wide;
+
+    same(wide, "{\"b\": 1, \"v\": [1, 2]}", "int32 record");
+    same(wide, "{\"b\": 3000000000, \"v\": [3000000000, 1]}", "int64 values in int32 shape");
+    same(wide, "{\"b\": -2147483648, \"v\": [-2147483648, 2147483647]}", "int32 limits");
+
+    doc.reset();
+    doc.Parse("{\"b\": 3000000000, \"v\": [3000000000, -2147483649]}", wide);
+
+    check(doc["b"].getInt64()==3000000000LL, "int64 member with shape");
+    check(doc.toStr().find("[ 3000000000, -2147483649 ]")!=std::string::npos, "int64 array");
+
+    JSON plain;
+    plain.Parse("{\"v\": [3000000000, 1]}");
+
+    check(plain.toStr().find("[ 3000000000, 1 ]")!=std::string::npos, "int64 array of short numbers");
+
+    plain.reset();
+    plain.Parse("{\"b\": 2147483648, \"c\": -2147483648}");
+
+    check(plain["b"].getInt64()==2147483648LL&&plain["c"].getInt64()==-2147483648LL, "int64 member");
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}
@@ -0,0 +1,109 @@
+/* validate() has to accept RFC 8259 JSON text and report the
+ * reason and position of the first error in anything else */
+
+#include <cstdio>
+#include <cstring>
+#include "../jsoner.h"
+
+using namespace J;
+
+static int failed=0;
+
+void valid(const std::string& input){
+    Status st=validate(input.data(), input.size());
+
+    if (!st){
+        printf("FAIL: %s\n  rejected: %s at %zu\n", input.c_str(), st.reason, st.offset);
+        ++failed;
+    }
+}
+
+/* input has to be rejected at offset, line and column for reason */
+void invalid(const std::string& input, size_t offset, size_t line, size_t column, const char* reason){
+    Status st=validate(input.data(), input.size());
+
+    if (st||st.offset!=offset||st.line!=line||st.column!=column||strcmp(st.reason, reason)!=0){
+        printf("FAIL: %s\n  expected: %s at %zu (%zu:%zu)\n  got: %s %s at %zu (%zu:%zu)\n",
+               input.c_str(), reason, offset, line, column,
+               st?"accepted":"rejected", st.reason, st.offset, st.line, st.column);
+        ++failed;
+    }
+}
+
+int main(){
+    /* scalars at top level, whitespace around */
+    valid("0");
+    valid("-0");
+    valid(" \t\r\n1.5e+10 \n");
+    valid("-12.25E-3");
+    valid("\"\"");
+    valid("true");
+    valid("false");
+    valid("null");
+
+    /* strings with escapes, long runs and UTF-8 */
+    valid("\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\\u00e9\"");
+    valid("\"" + std::string(100, 'x') + "\\n" + std::string(13, 'y') + "\"");
+    valid("\"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80\"");
+
+    /* containers */
+    valid("{}");
+    valid("[]");
+    valid("[ ]");
+    valid("{\"a\": [1, {\"b\": null}, []], \"c\": {}}");
+    valid("[[[[[[[[[[1]]]]]]]]]]");
+
+    /* numbers */
+    invalid("01", 1, 1, 2, "unexpected data after value");
+    invalid("[1.]", 3, 1, 4, "invalid number");
+    invalid("[.5]", 1, 1, 2, "unexpected character");
+    invalid("[-]", 1, 1, 2, "invalid number");
+    invalid("[1e]", 3, 1, 4, "invalid number");
+    invalid("[1e+]", 4, 1, 5, "invalid number");
+    invalid("[+1]", 1, 1, 2, "unexpected character");
+
+    /* literals */
+    invalid("tru", 0, 1, 1, "invalid literal");
+    invalid("[nul]", 1, 1, 2, "invalid literal");
+    invalid("True", 0, 1, 1, "unexpected character");
+
+    /* strings */
+    invalid("\"abc", 4, 1, 5, "unterminated string");
+    invalid("\"" + std::string(20, 'x'), 21, 1, 22, "unterminated string");
+    invalid("\"a\tb\"", 2, 1, 3, "control character in string");
+    invalid("\"a\\x\"", 2, 1, 3, "invalid escape");
+    invalid("\"\\u12g4\"", 1, 1, 2, "invalid unicode escape");
+    invalid("\"\xC3\"", 1, 1, 2, "invalid UTF-8");
+    invalid("\"\xED\xA0\x80\"", 1, 1, 2, "invalid UTF-8");
+
+    /* structure */
+    invalid("", 0, 1, 1, "unexpected end of input");
+    invalid("[1, 2", 5, 1, 6, "unexpected end of input");
+    invalid("[1 2]", 3, 1, 4, "expected ',' or ']'");
+    invalid("[1,]", 3, 1, 4, "unexpected character");
+    invalid("{\"a\": 1,}", 8, 1, 9, "expected string key");
+    invalid("{a: 1}", 1, 1, 2, "expected string key");
+    invalid("{\"a\" 1}", 5, 1, 6, "expected ':'");
+    invalid("{\"a\": 1]", 7, 1, 8, "expected ',' or '}'");
+    invalid("[1] [2]", 4, 1, 5, "unexpected data after value");
+
+    /* lines and columns */
+    invalid("{\n  \"a\": 1,\n  \"b\": tru\n}", 19, 3, 8, "invalid literal");
+    invalid("[\r\n1,\n\n   x]", 10, 4, 4, "unexpected character");
+
+    /* depth limit */
+    std::string deep(600, '[');
+    deep+=std::string(600, ']');
+    invalid(deep, 512, 1, 513, "maximum depth exceeded");
+
+    Status st=validate(deep.data(), deep.size(), 1000);
+    if (!st){
+        printf("FAIL: larger max_depth\n");
+        ++failed;
+    }
+
+    if (!failed)
+        printf("ok\n");
+
+    return failed?1:0;
+}